@@ -14,6 +14,7 @@ private let commandCharacteristicUUID = CBUUID(string: "0C1D2E3F-4051-6273-8495-
 private let maxLights = 300
 private let frameCommandId: UInt8 = 0xA0
 private let rainbowCommandId: UInt8 = 0xA1
+private let frameDeltaCommandId: UInt8 = 0xA3
 private let bleDeviceName = "PSL"
 private let bleShortName = "PSL"
 
@@ -149,6 +150,7 @@ struct ContentView: View {
     @State private var rainbowPhase: Double = 0
     @State private var rainbowTimer: AnyCancellable?
     @State private var lastRainbowTimestamp: TimeInterval = 0
+    @State private var frameEncoder = LEDFrameDeltaEncoder()
     private let rainbowLength: Double = 300
     private let rainbowCycleRate: Double = 0.1
 
@@ -291,7 +293,7 @@ struct ContentView: View {
     private func currentFramePayload() -> Data? {
         let runs = buildCurrentRuns()
         guard !runs.isEmpty else { return nil }
-        return LEDFrame(runs: runs).dataPayload()
+        return frameEncoder.payload(for: runs)
     }
 
     private func sendRainbowFrame() {
@@ -302,7 +304,7 @@ struct ContentView: View {
     private func rainbowPayload() -> Data? {
         let runs = buildRainbowRuns()
         guard !runs.isEmpty else { return nil }
-        return LEDFrame(runs: runs).dataPayload()
+        return frameEncoder.payload(for: runs)
     }
 
     private func buildCurrentRuns() -> [LEDFrameRun] {
@@ -478,7 +480,7 @@ struct ContentView: View {
     ContentView()
 }
 
-private struct LEDColor {
+private struct LEDColor: Equatable {
     let red: UInt8
     let green: UInt8
     let blue: UInt8
@@ -486,7 +488,7 @@ private struct LEDColor {
     static let off = LEDColor(red: 0, green: 0, blue: 0)
 }
 
-private struct LEDFrameRun {
+private struct LEDFrameRun: Equatable {
     let start: UInt16
     let length: UInt16
     let color: LEDColor
@@ -514,6 +516,60 @@ private struct LEDFrame {
     }
 }
 
+/// Sends 0xA3 deltas against the last frame when only colors changed, with a
+/// full 0xA0 frame whenever the run layout changes and once a second so the
+/// peripheral recovers from a dropped write or a reconnect.
+private final class LEDFrameDeltaEncoder {
+    private static let keyframeInterval = 30
+
+    private var lastRuns: [LEDFrameRun] = []
+    private var sequence: UInt8 = 0
+    private var deltasSinceKeyframe = 0
+
+    func payload(for runs: [LEDFrameRun]) -> Data? {
+        if let delta = deltaPayload(for: runs) {
+            lastRuns = runs
+            sequence &+= 1
+            deltasSinceKeyframe += 1
+            return delta
+        }
+        guard let full = LEDFrame(runs: runs).dataPayload() else { return nil }
+        lastRuns = runs
+        sequence = 0
+        deltasSinceKeyframe = 0
+        return full
+    }
+
+    private func deltaPayload(for runs: [LEDFrameRun]) -> Data? {
+        guard !lastRuns.isEmpty,
+              runs.count == lastRuns.count,
+              deltasSinceKeyframe < Self.keyframeInterval else { return nil }
+
+        var bitmap = [UInt8](repeating: 0, count: (runs.count * 3 + 7) / 8)
+        var deltas: [UInt8] = []
+        for (index, (old, new)) in zip(lastRuns, runs).enumerated() {
+            guard old.start == new.start, old.length == new.length else { return nil }
+            let channels = [(old.color.red, new.color.red),
+                            (old.color.green, new.color.green),
+                            (old.color.blue, new.color.blue)]
+            for (channel, (before, after)) in channels.enumerated() where before != after {
+                let bit = index * 3 + channel
+                bitmap[bit / 8] |= UInt8(1 << (bit % 8))
+                deltas.append(after &- before)
+            }
+        }
+
+        var payload = Data()
+        payload.append(frameDeltaCommandId)
+        payload.append(1)
+        payload.append(sequence &+ 1)
+        payload.append(UInt8(runs.count))
+        payload.append(contentsOf: bitmap)
+        payload.append(contentsOf: deltas)
+        return payload
+    }
+}
+
 private extension UInt16 {
     var littleEndianBytes: [UInt8] {
         let value = self.littleEndian
@@ -0,0 +1,486 @@
+/*
+ * Host microbenchmarks for the per-packet and per-frame kernels. Each case
+ * is calibrated to a batch of at least PSL_BENCH_BATCH_NS, timed
+ * PSL_BENCH_SAMPLES times, and reported as best and median ns/op plus
+ * bytes/s over the packet or pixel bytes each op handles.
+ *
+ *   psl_bench [--csv] [--filter <substring>] [--baseline <file.csv>]
+ *
+ * --csv prints one row per case for keeping as a baseline; --baseline
+ * compares the best ns/op against such a file. Numbers are for the host CPU:
+ * use them to compare changes, the target's own counts come from bench.c.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bitplane.h"
+#include "color.h"
+#include "command_parser.h"
+#include "frame_protocol.h"
+#include "motion_protocol.h"
+#include "pixel_pack.h"
+#include "run_list.h"
+
+#define PSL_BENCH_SAMPLES 15u
+#define PSL_BENCH_BATCH_NS 2000000u
+#define PSL_BENCH_MAX_LEDS 1024u
+#define PSL_BENCH_FRAME_RUNS 50u
+#define PSL_BENCH_MAX_BASELINE 128u
+
+typedef struct bench_case bench_case_t;
+
+struct bench_case {
+    const char *name;
+    /* Work units (pixels, runs or packets) and bytes handled per op. */
+    uint32_t items;
+    uint32_t bytes;
+    void (*setup)(const bench_case_t *bench);
+    void (*run)(const bench_case_t *bench);
+    uint32_t leds;
+    const char *text;
+};
+
+typedef struct {
+    char name[64];
+    double ns_per_op;
+} baseline_entry_t;
+
+static volatile uint32_t bench_sink;
+
+static color_rgb_t pixels[PSL_BENCH_MAX_LEDS];
+static color_rgb16_t linear[PSL_BENCH_MAX_LEDS];
+static pixel_dither_error_t dither_error[PSL_BENCH_MAX_LEDS];
+static uint32_t words[PSL_BENCH_MAX_LEDS];
+static uint32_t planes[2][(PSL_BENCH_MAX_LEDS / BITPLANE_LANES + 1u) * BITPLANE_WORDS_PER_ROW];
+static uint16_t lane_start[BITPLANE_LANES];
+static uint16_t lane_len[BITPLANE_LANES];
+static uint16_t lane_rows;
+static run_list_t run_list;
+static uint8_t packet[PSL_FRAME_PIXELS_HEADER_LEN + PSL_BENCH_MAX_LEDS * 3u];
+static size_t packet_len;
+static frame_base_t delta_base;
+
+static baseline_entry_t baseline[PSL_BENCH_MAX_BASELINE];
+static uint32_t baseline_count;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void put_u16_le(uint8_t *p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static void fill_rainbow(uint32_t leds) {
+    for (uint32_t i = 0; i < leds; ++i) {
+        pixels[i] = color_hsv16_to_rgb((uint16_t)(i * (65536u / leds)), 255, 255);
+    }
+}
+
+/* ---- colour ---- */
+
+static void run_hsv16(const bench_case_t *bench) {
+    const uint16_t hue_step = (uint16_t)(65536u / bench->leds);
+    uint32_t acc = 0;
+    uint16_t hue = 0;
+    for (uint32_t i = 0; i < bench->leds; ++i) {
+        color_rgb_t rgb = color_hsv16_to_rgb(hue, 255, 128);
+        acc += rgb.r + rgb.g + rgb.b;
+        hue = (uint16_t)(hue + hue_step);
+    }
+    bench_sink = acc;
+}
+
+/* What the renderer does per motion packet: map the angles, convert once,
+ * fill the segment. */
+static void run_motion_color(const bench_case_t *bench) {
+    static uint32_t tick;
+    float yaw = (float)(tick++ & 1023u) * (6.28f / 1024.0f) - 3.14f;
+    motion_color_t color = motion_color_from_angles(0.123f, -1.570f, yaw);
+    color_rgb_t rgb = color_hsv16_to_rgb(color_hue16_from_degrees(color.hue),
+                                         color_unit_to_u8(color.saturation), 255);
+    for (uint32_t i = 0; i < bench->leds; ++i) {
+        pixels[i] = rgb;
+    }
+    pixel_pack_set_brightness(color_unit_to_u8(color.brightness));
+    bench_sink = pixels[bench->leds - 1u].g;
+}
+
+/* ---- packet decode ---- */
+
+static void run_text_parse(const bench_case_t *bench) {
+    psl_command_t command;
+    command_parse_result_t result = command_parse_text((const uint8_t *)bench->text, bench->bytes, &command);
+    bench_sink = (uint32_t)result + command.u.index;
+}
+
+static const uint8_t motion_packet[] = {
+    PSL_MOTION_COMMAND_ID, PSL_MOTION_FLAG_SEQ | PSL_MOTION_FLAG_TIMESTAMP,
+    0xf0, 0x03, 0xc3, 0xcd, 0x83, 0x64, /* 0.123, -1.570, 3.141 rad */
+    0x2a, 0x00, 0x10, 0x27, 0x00, 0x00,
+};
+
+static void run_motion_decode(const bench_case_t *bench) {
+    (void)bench;
+    motion_packet_t decoded;
+    if (motion_packet_decode(motion_packet, sizeof(motion_packet), &decoded) == MOTION_PARSE_OK) {
+        bench_sink = (uint32_t)decoded.yaw + decoded.seq;
+    }
+}
+
+/* ---- frame apply ---- */
+
+/* 0xA0 frame of PSL_BENCH_FRAME_RUNS equal runs covering the strip. */
+static void setup_frame_runs(const bench_case_t *bench) {
+    const uint16_t run_len = (uint16_t)(bench->leds / PSL_BENCH_FRAME_RUNS);
+    packet[0] = PSL_FRAME_COMMAND_ID;
+    packet[1] = PSL_FRAME_VERSION;
+    packet[2] = (uint8_t)PSL_BENCH_FRAME_RUNS;
+    uint8_t *p = packet + PSL_FRAME_HEADER_LEN;
+    for (uint32_t i = 0; i < PSL_BENCH_FRAME_RUNS; ++i) {
+        color_rgb_t rgb = color_hsv16_to_rgb((uint16_t)(i * (65536u / PSL_BENCH_FRAME_RUNS)), 255, 255);
+        put_u16_le(p, (uint16_t)(i * run_len));
+        put_u16_le(p + 2, run_len);
+        p[4] = rgb.r;
+        p[5] = rgb.g;
+        p[6] = rgb.b;
+        p += PSL_FRAME_RUN_LEN;
+    }
+    packet_len = (size_t)(p - packet);
+}
+
+static void run_frame_runs(const bench_case_t *bench) {
+    frame_reader_t reader;
+    frame_run_t run;
+    if (frame_reader_init(&reader, packet, packet_len) == FRAME_PARSE_OK) {
+        while (frame_reader_next(&reader, &run)) {
+            frame_apply_run(pixels, (uint16_t)bench->leds, &run);
+        }
+    }
+    bench_sink = pixels[bench->leds - 1u].g;
+}
+
+/* 0xA3 delta nudging one channel of every run, against setup_frame_runs(). */
+static void setup_frame_delta(const bench_case_t *bench) {
+    setup_frame_runs(bench);
+    frame_reader_t reader;
+    frame_run_t run;
+    frame_base_begin(&delta_base);
+    if (frame_reader_init(&reader, packet, packet_len) == FRAME_PARSE_OK) {
+        while (frame_reader_next(&reader, &run)) {
+            frame_base_append(&delta_base, &run);
+        }
+    }
+    const size_t bitmap_len = (PSL_BENCH_FRAME_RUNS * 3u + 7u) / 8u;
+    memset(packet, 0, PSL_FRAME_DELTA_HEADER_LEN + bitmap_len + PSL_BENCH_FRAME_RUNS);
+    packet[0] = PSL_FRAME_DELTA_COMMAND_ID;
+    packet[1] = PSL_FRAME_VERSION;
+    packet[3] = (uint8_t)PSL_BENCH_FRAME_RUNS;
+    uint8_t *bitmap = packet + PSL_FRAME_DELTA_HEADER_LEN;
+    uint8_t *deltas = bitmap + bitmap_len;
+    for (uint32_t i = 0; i < PSL_BENCH_FRAME_RUNS; ++i) {
+        uint32_t bit = i * 3u + (i % 3u);
+        bitmap[bit >> 3] |= (uint8_t)(1u << (bit & 7u));
+        deltas[i] = (i & 1u) ? 0xFB : 0x05;
+    }
+    packet_len = PSL_FRAME_DELTA_HEADER_LEN + bitmap_len + PSL_BENCH_FRAME_RUNS;
+}
+
+static void run_frame_delta(const bench_case_t *bench) {
+    packet[2] = (uint8_t)(delta_base.delta_seq + 1u);
+    frame_delta_reader_t reader;
+    frame_run_t run;
+    if (frame_delta_reader_init(&reader, &delta_base, packet, packet_len) == FRAME_PARSE_OK) {
+        while (frame_delta_reader_next(&reader, &run)) {
+            frame_apply_run(pixels, (uint16_t)bench->leds, &run);
+        }
+    }
+    bench_sink = pixels[0].r;
+}
+
+static void setup_frame_pixels(const bench_case_t *bench) {
+    packet[0] = PSL_FRAME_PIXELS_COMMAND_ID;
+    packet[1] = PSL_FRAME_VERSION;
+    put_u16_le(packet + 2, 0);
+    put_u16_le(packet + 4, (uint16_t)bench->leds);
+    for (uint32_t i = 0; i < bench->leds * 3u; ++i) {
+        packet[PSL_FRAME_PIXELS_HEADER_LEN + i] = (uint8_t)(i * 7u);
+    }
+    packet_len = PSL_FRAME_PIXELS_HEADER_LEN + bench->leds * 3u;
+}
+
+static void run_frame_pixels(const bench_case_t *bench) {
+    frame_pixels_t frame;
+    if (frame_pixels_parse(packet, packet_len, &frame) == FRAME_PARSE_OK) {
+        frame_apply_pixels(pixels, (uint16_t)bench->leds, frame.start, frame.rgb, frame.count);
+    }
+    bench_sink = pixels[bench->leds - 1u].b;
+}
+
+/* ---- output stage ---- */
+
+static void setup_pack(const bench_case_t *bench) {
+    fill_rainbow(bench->leds);
+    pixel_pack_set_brightness(200);
+}
+
+static void run_pack_grb(const bench_case_t *bench) {
+    pixel_pack_grb(words, pixels, (uint16_t)bench->leds);
+    bench_sink = words[bench->leds - 1u];
+}
+
+/* Brightness changes rebuild the table, then re-pack. */
+static void run_brightness_pack(const bench_case_t *bench) {
+    static uint8_t level;
+    pixel_pack_set_brightness((uint8_t)(64u + (level++ & 63u)));
+    pixel_pack_grb(words, pixels, (uint16_t)bench->leds);
+    bench_sink = words[bench->leds - 1u];
+}
+
+static void setup_dither(const bench_case_t *bench) {
+    fill_rainbow(bench->leds);
+    pixel_pack_set_brightness(13); /* the 5% floor */
+    pixel_pack_linearize(linear, pixels, (uint16_t)bench->leds);
+    pixel_pack_dither_reset(dither_error, (uint16_t)bench->leds);
+}
+
+static void run_linearize(const bench_case_t *bench) {
+    pixel_pack_linearize(linear, pixels, (uint16_t)bench->leds);
+    bench_sink = linear[bench->leds - 1u].g;
+}
+
+static void run_pack_dithered(const bench_case_t *bench) {
+    pixel_pack_grb_dithered(words, linear, dither_error, (uint16_t)bench->leds);
+    bench_sink = words[bench->leds / 2u];
+}
+
+/* The strip split over 8 lanes as the parallel output engine sends it. */
+static void setup_transpose(const bench_case_t *bench) {
+    setup_pack(bench);
+    pixel_pack_grb(words, pixels, (uint16_t)bench->leds);
+    lane_rows = 0;
+    for (uint32_t lane = 0; lane < BITPLANE_LANES; ++lane) {
+        lane_start[lane] = (uint16_t)(lane * bench->leds / BITPLANE_LANES);
+        lane_len[lane] = (uint16_t)((lane + 1u) * bench->leds / BITPLANE_LANES - lane_start[lane]);
+        if (lane_len[lane] > lane_rows) {
+            lane_rows = lane_len[lane];
+        }
+    }
+}
+
+/* Bit by bit, as a reference for the 8x8 transpose. */
+static void transpose_naive(uint32_t *out) {
+    for (uint16_t row = 0; row < lane_rows; ++row) {
+        for (uint32_t bit = 0; bit < BITPLANE_WORDS_PER_ROW; ++bit) {
+            uint32_t plane = 0;
+            for (uint32_t lane = 0; lane < BITPLANE_LANES; ++lane) {
+                uint32_t grb = row < lane_len[lane] ? words[lane_start[lane] + row] : 0u;
+                plane |= ((grb >> (31u - bit)) & 1u) << lane;
+            }
+            out[row * BITPLANE_WORDS_PER_ROW + bit] = plane;
+        }
+    }
+}
+
+static void setup_transpose_checked(const bench_case_t *bench) {
+    setup_transpose(bench);
+    bitplane_transpose(planes[0], words, lane_start, lane_len, BITPLANE_LANES, lane_rows);
+    transpose_naive(planes[1]);
+    if (memcmp(planes[0], planes[1], lane_rows * BITPLANE_WORDS_PER_ROW * sizeof(uint32_t)) != 0) {
+        fprintf(stderr, "%s: bitplane_transpose() disagrees with the reference\n", bench->name);
+        exit(1);
+    }
+}
+
+static void run_transpose(const bench_case_t *bench) {
+    (void)bench;
+    bitplane_transpose(planes[0], words, lane_start, lane_len, BITPLANE_LANES, lane_rows);
+    bench_sink = planes[0][lane_rows * BITPLANE_WORDS_PER_ROW - 1u];
+}
+
+static void run_transpose_naive(const bench_case_t *bench) {
+    (void)bench;
+    transpose_naive(planes[1]);
+    bench_sink = planes[1][lane_rows * BITPLANE_WORDS_PER_ROW - 1u];
+}
+
+/* ---- run-list output ---- */
+
+/* The 50-run frame the frame_runs cases decode, as a run list. */
+static void setup_run_list(const bench_case_t *bench) {
+    const uint16_t run_len = (uint16_t)(bench->leds / PSL_BENCH_FRAME_RUNS);
+    run_list_reset(&run_list, (uint16_t)bench->leds, 0);
+    for (uint32_t i = 0; i < PSL_BENCH_FRAME_RUNS; ++i) {
+        color_rgb_t rgb = color_hsv16_to_rgb((uint16_t)(i * (65536u / PSL_BENCH_FRAME_RUNS)), 255, 255);
+        run_list_paint(&run_list, (uint16_t)(i * run_len), run_len, color_rgb_to_grb(rgb) << 8);
+    }
+}
+
+static void run_run_list_paint(const bench_case_t *bench) {
+    setup_run_list(bench);
+    bench_sink = run_list.count;
+}
+
+/* Expanded a line buffer at a time, as the DMA IRQ streams it. */
+static void run_run_list_expand(const bench_case_t *bench) {
+    for (uint32_t at = 0; at < bench->leds; at += 32u) {
+        uint32_t n = bench->leds - at < 32u ? bench->leds - at : 32u;
+        run_list_expand(&run_list, (uint16_t)at, words, (uint16_t)n);
+    }
+    bench_sink = words[0];
+}
+
+/* The label is the packet with ',' as '_', so names stay one CSV field. */
+#define TEXT_CASE(label, str) {"parse_text/" label, 1, sizeof(str) - 1u, NULL, run_text_parse, 0, str}
+#define FRAME_LEN (PSL_FRAME_HEADER_LEN + PSL_BENCH_FRAME_RUNS * PSL_FRAME_RUN_LEN)
+#define DELTA_LEN (PSL_FRAME_DELTA_HEADER_LEN + (PSL_BENCH_FRAME_RUNS * 3u + 7u) / 8u + PSL_BENCH_FRAME_RUNS)
+
+static const bench_case_t bench_cases[] = {
+    {"hsv16_to_rgb/300", 300, 300 * 3, NULL, run_hsv16, 300, NULL},
+    {"motion_color/300", 300, 300 * 3, NULL, run_motion_color, 300, NULL},
+    TEXT_CASE("0.123_-1.570_3.141", "0.123,-1.570,3.141"),
+    TEXT_CASE("H_SET_212.5", "H_SET,212.5"),
+    TEXT_CASE("B_SET_75", "B_SET,75"),
+    TEXT_CASE("H_-4.25", "H,-4.25"),
+    TEXT_CASE("SEG_START_12", "SEG_START,12"),
+    TEXT_CASE("SEG_END_288", "SEG_END,288"),
+    TEXT_CASE("RESET", "RESET"),
+    {"motion_decode/0xA2", 1, sizeof(motion_packet), NULL, run_motion_decode, 0, NULL},
+    {"frame_runs/300", PSL_BENCH_FRAME_RUNS, FRAME_LEN, setup_frame_runs, run_frame_runs, 300, NULL},
+    {"frame_runs/1024", PSL_BENCH_FRAME_RUNS, FRAME_LEN, setup_frame_runs, run_frame_runs, 1024, NULL},
+    {"frame_delta/300", PSL_BENCH_FRAME_RUNS, DELTA_LEN, setup_frame_delta, run_frame_delta, 300, NULL},
+    {"frame_pixels/300", 300, PSL_FRAME_PIXELS_HEADER_LEN + 300 * 3, setup_frame_pixels, run_frame_pixels, 300,
+     NULL},
+    {"frame_pixels/1024", 1024, PSL_FRAME_PIXELS_HEADER_LEN + 1024 * 3, setup_frame_pixels, run_frame_pixels,
+     1024, NULL},
+    {"pack_grb/300", 300, 300 * 3, setup_pack, run_pack_grb, 300, NULL},
+    {"pack_grb/1024", 1024, 1024 * 3, setup_pack, run_pack_grb, 1024, NULL},
+    {"brightness_pack/300", 300, 300 * 3, setup_pack, run_brightness_pack, 300, NULL},
+    {"brightness_pack/1024", 1024, 1024 * 3, setup_pack, run_brightness_pack, 1024, NULL},
+    {"dither_linearize/300", 300, 300 * 3, setup_dither, run_linearize, 300, NULL},
+    {"dither_linearize/1024", 1024, 1024 * 3, setup_dither, run_linearize, 1024, NULL},
+    {"pack_dithered/300", 300, 300 * 6, setup_dither, run_pack_dithered, 300, NULL},
+    {"pack_dithered/1024", 1024, 1024 * 6, setup_dither, run_pack_dithered, 1024, NULL},
+    {"bitplane_transpose/300", 300, 300 * 3, setup_transpose_checked, run_transpose, 300, NULL},
+    {"bitplane_transpose/1024", 1024, 1024 * 3, setup_transpose_checked, run_transpose, 1024, NULL},
+    {"bitplane_naive/300", 300, 300 * 3, setup_transpose, run_transpose_naive, 300, NULL},
+    {"run_list_paint/300", PSL_BENCH_FRAME_RUNS, FRAME_LEN, NULL, run_run_list_paint, 300, NULL},
+    {"run_list_expand/300", 300, 300 * 4, setup_run_list, run_run_list_expand, 300, NULL},
+    {"run_list_expand/8192", 8192, 8192 * 4, setup_run_list, run_run_list_expand, 8192, NULL},
+};
+
+static uint64_t time_batch(const bench_case_t *bench, uint64_t ops) {
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < ops; ++i) {
+        bench->run(bench);
+    }
+    return now_ns() - start;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void load_baseline(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "psl_bench: cannot open baseline %s\n", path);
+        exit(2);
+    }
+    char line[256];
+    uint32_t line_number = 0;
+    while (fgets(line, sizeof(line), file) && baseline_count < PSL_BENCH_MAX_BASELINE) {
+        baseline_entry_t *entry = &baseline[baseline_count];
+        line_number++;
+        /* name,items,bytes_per_op,ns_per_op,... after the header row */
+        if (line[0] == '#' || line[0] == '\n' || strncmp(line, "name,", 5) == 0) {
+            continue;
+        }
+        if (sscanf(line, "%63[^,],%*u,%*u,%lf", entry->name, &entry->ns_per_op) != 2) {
+            fprintf(stderr, "psl_bench: %s:%u: not a baseline row, skipped\n", path, line_number);
+            continue;
+        }
+        baseline_count++;
+    }
+    fclose(file);
+}
+
+static const baseline_entry_t *find_baseline(const char *name) {
+    for (uint32_t i = 0; i < baseline_count; ++i) {
+        if (strcmp(baseline[i].name, name) == 0) {
+            return &baseline[i];
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    bool csv = false;
+    const char *filter = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            load_baseline(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--csv] [--filter <substring>] [--baseline <file.csv>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (csv) {
+        printf("name,items,bytes_per_op,ns_per_op,ns_per_op_median,ns_per_item,bytes_per_s\n");
+    } else {
+        printf("%-32s %10s %10s %9s %12s%s\n", "case", "ns/op", "median", "ns/item", "MB/s",
+               baseline_count ? "   vs baseline" : "");
+    }
+
+    for (size_t c = 0; c < sizeof(bench_cases) / sizeof(bench_cases[0]); ++c) {
+        const bench_case_t *bench = &bench_cases[c];
+        if (filter && !strstr(bench->name, filter)) {
+            continue;
+        }
+        if (bench->setup) {
+            bench->setup(bench);
+        }
+
+        uint64_t ops = 1;
+        while (time_batch(bench, ops) < PSL_BENCH_BATCH_NS) {
+            ops *= 2u;
+        }
+        uint64_t samples[PSL_BENCH_SAMPLES];
+        for (uint32_t s = 0; s < PSL_BENCH_SAMPLES; ++s) {
+            samples[s] = time_batch(bench, ops);
+        }
+        qsort(samples, PSL_BENCH_SAMPLES, sizeof(samples[0]), compare_u64);
+
+        double best = (double)samples[0] / (double)ops;
+        double median = (double)samples[PSL_BENCH_SAMPLES / 2u] / (double)ops;
+        double per_item = best / bench->items;
+        double bytes_per_s = best > 0.0 ? bench->bytes * 1e9 / best : 0.0;
+        if (csv) {
+            printf("%s,%u,%u,%.2f,%.2f,%.3f,%.0f\n", bench->name, bench->items, bench->bytes, best, median,
+                   per_item, bytes_per_s);
+            continue;
+        }
+        printf("%-32s %10.1f %10.1f %9.2f %12.1f", bench->name, best, median, per_item, bytes_per_s / 1e6);
+        const baseline_entry_t *base = find_baseline(bench->name);
+        if (base && base->ns_per_op > 0.0) {
+            printf("   %+6.1f%%", (best - base->ns_per_op) * 100.0 / base->ns_per_op);
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,278 @@
+#include "pio_emu.h"
+
+/* Instruction fields, RP2040 datasheet section 3.4. */
+#define PIO_OP(instr) (((instr) >> 13) & 7u)
+#define PIO_DELAY_SIDESET(instr) (((instr) >> 8) & 0x1fu)
+#define PIO_ARG1(instr) (((instr) >> 5) & 7u)
+#define PIO_ARG2(instr) ((instr) & 0x1fu)
+
+enum {
+    PIO_OP_JMP = 0,
+    PIO_OP_WAIT,
+    PIO_OP_IN,
+    PIO_OP_OUT,
+    PIO_OP_PUSH_PULL,
+    PIO_OP_MOV,
+    PIO_OP_IRQ,
+    PIO_OP_SET
+};
+
+/* A frame-sized run plus slack; a run past this has stopped making progress. */
+#define PIO_EMU_CYCLES_PER_WORD_LIMIT 4096u
+
+typedef struct {
+    const uint16_t *instructions;
+    const pio_sm_config *config;
+    const uint32_t *words;
+    uint32_t word_count;
+    uint32_t next_word;
+    uint32_t osr;
+    uint32_t osr_count;
+    uint32_t x;
+    uint32_t y;
+    uint32_t pins;
+    uint32_t pindirs;
+    pio_emu_edge_t *edges;
+    uint32_t max_edges;
+    uint32_t edge_count;
+    bool edges_full;
+} pio_emu_t;
+
+static uint32_t pin_mask(uint base, uint count) {
+    uint32_t mask = count >= 32u ? 0xffffffffu : ((1u << count) - 1u);
+    return (mask << base) | (base ? mask >> (32u - base) : 0u);
+}
+
+static uint32_t rotate_to_pins(uint32_t value, uint base) {
+    return base ? (value << base) | (value >> (32u - base)) : value;
+}
+
+static void write_pins(pio_emu_t *emu, uint base, uint count, uint32_t value) {
+    uint32_t mask = pin_mask(base, count);
+    emu->pins = (emu->pins & ~mask) | (rotate_to_pins(value, base) & mask);
+}
+
+static void record_pins(pio_emu_t *emu, uint64_t cycle) {
+    if (emu->edge_count && emu->edges[emu->edge_count - 1u].pins == emu->pins) {
+        return;
+    }
+    if (emu->edge_count == emu->max_edges) {
+        emu->edges_full = true;
+        return;
+    }
+    emu->edges[emu->edge_count].cycle = cycle;
+    emu->edges[emu->edge_count].pins = emu->pins;
+    emu->edge_count++;
+}
+
+/* Side-set takes effect on the first cycle of the instruction, stalled or not. */
+static uint32_t apply_sideset(pio_emu_t *emu, uint16_t instr) {
+    const pio_sm_config *config = emu->config;
+    uint field = PIO_DELAY_SIDESET(instr);
+    uint bits = config->sideset_bit_count;
+    uint delay_bits = 5u - bits;
+    uint32_t delay = field & ((1u << delay_bits) - 1u);
+    if (bits) {
+        uint32_t sideset = field >> delay_bits;
+        uint value_bits = bits;
+        bool enabled = true;
+        if (config->sideset_optional) {
+            value_bits--;
+            enabled = (sideset >> value_bits) & 1u;
+            sideset &= (1u << value_bits) - 1u;
+        }
+        if (enabled && value_bits) {
+            write_pins(emu, config->sideset_base, value_bits, sideset);
+        }
+    }
+    return delay;
+}
+
+/* OSR empty per the autopull threshold: refill from the FIFO, or stall. */
+static bool autopull(pio_emu_t *emu) {
+    if (emu->osr_count < emu->config->pull_threshold) {
+        return true;
+    }
+    if (emu->next_word == emu->word_count) {
+        return false;
+    }
+    emu->osr = emu->words[emu->next_word++];
+    emu->osr_count = 0;
+    return true;
+}
+
+static uint32_t shift_out(pio_emu_t *emu, uint count) {
+    uint32_t value;
+    if (count == 32u) {
+        value = emu->osr;
+        emu->osr = 0;
+    } else if (emu->config->out_shift_right) {
+        value = emu->osr & ((1u << count) - 1u);
+        emu->osr >>= count;
+    } else {
+        value = emu->osr >> (32u - count);
+        emu->osr <<= count;
+    }
+    emu->osr_count = emu->osr_count + count > 32u ? 32u : emu->osr_count + count;
+    return value;
+}
+
+static uint32_t bit_reverse(uint32_t value) {
+    uint32_t reversed = 0;
+    for (uint i = 0; i < 32u; ++i) {
+        reversed = (reversed << 1) | ((value >> i) & 1u);
+    }
+    return reversed;
+}
+
+static uint32_t mov_source(const pio_emu_t *emu, uint source) {
+    switch (source) {
+    case 0:
+        return emu->pins;
+    case 1:
+        return emu->x;
+    case 2:
+        return emu->y;
+    case 7:
+        return emu->osr;
+    default:
+        return 0;
+    }
+}
+
+pio_emu_result_t pio_emu_run(const uint16_t *instructions, const pio_sm_config *config, uint initial_pc,
+                             uint32_t initial_pins, const uint32_t *words, uint32_t word_count,
+                             pio_emu_edge_t *edges, uint32_t max_edges) {
+    pio_emu_t emu = {
+        .instructions = instructions,
+        .config = config,
+        .words = words,
+        .word_count = word_count,
+        /* pio_sm_init() leaves the OSR empty, so the first OUT pulls. */
+        .osr_count = 32u,
+        .pins = initial_pins,
+        .edges = edges,
+        .max_edges = max_edges,
+    };
+    pio_emu_result_t result = {0};
+    const uint64_t cycle_limit = ((uint64_t)word_count + 1u) * PIO_EMU_CYCLES_PER_WORD_LIMIT;
+    uint pc = initial_pc;
+    uint64_t cycle = 0;
+    record_pins(&emu, 0);
+
+    for (;;) {
+        const uint16_t instr = instructions[pc];
+        uint32_t delay = apply_sideset(&emu, instr);
+        const uint arg1 = PIO_ARG1(instr);
+        const uint arg2 = PIO_ARG2(instr);
+        uint next_pc = pc == config->wrap ? config->wrap_target : (pc + 1u) % PIO_INSTRUCTION_COUNT;
+        bool stalled = false;
+
+        switch (PIO_OP(instr)) {
+        case PIO_OP_JMP: {
+            bool taken;
+            switch (arg1) {
+            case 0: taken = true; break;
+            case 1: taken = emu.x == 0; break;
+            case 2: taken = emu.x-- != 0; break;
+            case 3: taken = emu.y == 0; break;
+            case 4: taken = emu.y-- != 0; break;
+            case 5: taken = emu.x != emu.y; break;
+            case 7: taken = emu.osr_count < config->pull_threshold; break;
+            default: taken = false; break; /* JMP PIN: no inputs here */
+            }
+            if (taken) {
+                next_pc = arg2;
+            }
+            break;
+        }
+        case PIO_OP_OUT: {
+            if (config->autopull && !autopull(&emu)) {
+                stalled = true;
+                break;
+            }
+            uint32_t value = shift_out(&emu, arg2 ? arg2 : 32u);
+            switch (arg1) {
+            case 0: write_pins(&emu, config->out_base, config->out_count, value); break;
+            case 1: emu.x = value; break;
+            case 2: emu.y = value; break;
+            case 3: break; /* null */
+            case 4: emu.pindirs = value; break;
+            default:
+                result.status = PIO_EMU_UNSUPPORTED;
+                result.bad_instruction = instr;
+                break;
+            }
+            break;
+        }
+        case PIO_OP_MOV: {
+            uint32_t value = mov_source(&emu, arg2 & 7u);
+            uint op = (arg2 >> 3) & 3u;
+            if (op == 1u) {
+                value = ~value;
+            } else if (op == 2u) {
+                value = bit_reverse(value);
+            }
+            switch (arg1) {
+            case 0: write_pins(&emu, config->out_base, config->out_count, value); break;
+            case 1: emu.x = value; break;
+            case 2: emu.y = value; break;
+            case 7: emu.osr = value; emu.osr_count = 0; break;
+            default:
+                result.status = PIO_EMU_UNSUPPORTED;
+                result.bad_instruction = instr;
+                break;
+            }
+            break;
+        }
+        case PIO_OP_SET:
+            switch (arg1) {
+            case 1: emu.x = arg2; break;
+            case 2: emu.y = arg2; break;
+            default:
+                result.status = PIO_EMU_UNSUPPORTED;
+                result.bad_instruction = instr;
+                break;
+            }
+            break;
+        default:
+            result.status = PIO_EMU_UNSUPPORTED;
+            result.bad_instruction = instr;
+            break;
+        }
+
+        record_pins(&emu, cycle);
+        if (result.status != PIO_EMU_OK) {
+            break;
+        }
+        if (emu.edges_full) {
+            result.status = PIO_EMU_EDGES_FULL;
+            break;
+        }
+        if (stalled) {
+            /* Nothing left to pull: the pins hold their side-set level. */
+            result.end_cycle = cycle;
+            break;
+        }
+        cycle += 1u + delay;
+        pc = next_pc;
+        if (cycle > cycle_limit) {
+            result.status = PIO_EMU_CYCLE_LIMIT;
+            break;
+        }
+    }
+
+    result.edge_count = emu.edge_count;
+    result.words_pulled = emu.next_word;
+    if (result.status != PIO_EMU_OK) {
+        result.end_cycle = cycle;
+    }
+    return result;
+}
+
+double pio_emu_cycle_ns(const pio_sm_config *config, uint32_t sys_hz) {
+    /* The divider is 16.8 fixed point and the SDK truncates; a fractional
+     * divider jitters individual cycles, this is their average. */
+    double div = (double)(uint32_t)((double)config->clkdiv * 256.0) / 256.0;
+    return 1e9 * div / (double)sys_hz;
+}
@@ -0,0 +1,54 @@
+#ifndef PIO_EMU_H
+#define PIO_EMU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hardware/pio.h"
+
+/*
+ * Cycle-accurate interpreter for one PIO state machine, enough of the
+ * RP2040 instruction set for output programs: JMP (all conditions), OUT,
+ * MOV, SET and side-set with delays, autopull from a TX FIFO that holds the
+ * whole frame. Pull stalls still apply side-set, and delays only start once
+ * an instruction completes, as on the hardware.
+ *
+ * The result is the GPIO output as a list of edges: every cycle on which
+ * any driven pin changes, with the pin levels from that cycle on. The run
+ * ends when the program stalls on an empty FIFO, the frame's idle state.
+ */
+
+typedef struct {
+    uint64_t cycle;
+    uint32_t pins;
+} pio_emu_edge_t;
+
+typedef enum {
+    PIO_EMU_OK = 0,
+    PIO_EMU_EDGES_FULL,
+    PIO_EMU_CYCLE_LIMIT,
+    PIO_EMU_UNSUPPORTED
+} pio_emu_status_t;
+
+typedef struct {
+    pio_emu_status_t status;
+    /* Cycle the final pull stall began: when the last bit left the pins. */
+    uint64_t end_cycle;
+    uint32_t edge_count;
+    uint32_t words_pulled;
+    /* The instruction that stopped the run, for PIO_EMU_UNSUPPORTED. */
+    uint16_t bad_instruction;
+} pio_emu_result_t;
+
+/*
+ * Run `words` through the program in `instructions` (the full 32-slot
+ * instruction memory) from initial_pc. Pins start at initial_pins; edges
+ * has room for max_edges entries, the first being the cycle 0 state.
+ */
+pio_emu_result_t pio_emu_run(const uint16_t *instructions, const pio_sm_config *config, uint initial_pc,
+                             uint32_t initial_pins, const uint32_t *words, uint32_t word_count,
+                             pio_emu_edge_t *edges, uint32_t max_edges);
+
+/* Mean nanoseconds per state machine cycle at the given system clock. */
+double pio_emu_cycle_ns(const pio_sm_config *config, uint32_t sys_hz);
+
+#endif
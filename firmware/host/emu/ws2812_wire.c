@@ -0,0 +1,114 @@
+#include "ws2812_wire.h"
+
+#include <string.h>
+#include "ws2812.pio.h"
+
+#define WS2812_WIRE_BITS_PER_PIXEL 24u
+#define WS2812_WIRE_MAX_DELAY 16u
+
+/* Which ws2812.pio instruction's delay each T sets. */
+#define WS2812_WIRE_OUT 0u
+#define WS2812_WIRE_JMP_HIGH 1u
+#define WS2812_WIRE_JMP_ONE 2u
+#define WS2812_WIRE_NOP_ZERO 3u
+#define WS2812_WIRE_DELAY_MASK 0x0f00u
+
+const ws2812_wire_spec_t ws2812_wire_spec_ws2812b = {
+    .name = "WS2812B",
+    .t0h_min_ns = 250,
+    .t0h_max_ns = 550,
+    .t1h_min_ns = 650,
+    .t1h_max_ns = 950,
+    .bit_min_ns = 650,
+    .bit_max_ns = 1850,
+    .reset_min_ns = 280000,
+};
+
+static bool in_window(double ns, uint32_t min_ns, uint32_t max_ns) {
+    return ns >= (double)min_ns && ns <= (double)max_ns;
+}
+
+void ws2812_wire_decode(const pio_emu_edge_t *edges, const pio_emu_result_t *run, double cycle_ns, uint pin,
+                        const ws2812_wire_spec_t *spec, uint32_t *grb, uint32_t max_pixels,
+                        ws2812_wire_report_t *report) {
+    memset(report, 0, sizeof(*report));
+    const double threshold_ns = ((double)spec->t0h_max_ns + (double)spec->t1h_min_ns) / 2.0;
+    const uint32_t mask = 1u << pin;
+    bool level = edges[0].pins & mask;
+    uint64_t rise = 0;
+    bool have_rise = false;
+    uint64_t last_fall = 0;
+    uint32_t pixel = 0;
+
+    for (uint32_t i = 1; i < run->edge_count; ++i) {
+        bool next = edges[i].pins & mask;
+        if (next == level) {
+            continue;
+        }
+        level = next;
+        uint64_t cycle = edges[i].cycle;
+        if (!level) {
+            if (!have_rise) {
+                continue;
+            }
+            last_fall = cycle;
+            double high_ns = (double)(cycle - rise) * cycle_ns;
+            bool one = high_ns >= threshold_ns;
+            if (one) {
+                report->t1h_violations += !in_window(high_ns, spec->t1h_min_ns, spec->t1h_max_ns);
+                report->t1h_ns = high_ns > report->t1h_ns ? high_ns : report->t1h_ns;
+            } else {
+                report->t0h_violations += !in_window(high_ns, spec->t0h_min_ns, spec->t0h_max_ns);
+                report->t0h_ns = high_ns > report->t0h_ns ? high_ns : report->t0h_ns;
+            }
+            pixel = (pixel << 1) | one;
+            report->bits++;
+            if (report->bits % WS2812_WIRE_BITS_PER_PIXEL == 0) {
+                if (report->pixels < max_pixels) {
+                    grb[report->pixels] = pixel & 0xffffffu;
+                }
+                report->pixels++;
+                pixel = 0;
+            }
+            continue;
+        }
+        if (have_rise) {
+            double bit_ns = (double)(cycle - rise) * cycle_ns;
+            report->bit_violations += !in_window(bit_ns, spec->bit_min_ns, spec->bit_max_ns);
+            report->bit_ns = bit_ns > report->bit_ns ? bit_ns : report->bit_ns;
+            if ((double)(cycle - last_fall) * cycle_ns >= (double)spec->reset_min_ns) {
+                report->early_latches++;
+            }
+        }
+        rise = cycle;
+        have_rise = true;
+    }
+    report->wire_ns = (double)run->end_cycle * cycle_ns;
+}
+
+bool ws2812_wire_timing_valid(const ws2812_wire_timing_t *timing) {
+    return timing->t1 >= 1u && timing->t1 <= WS2812_WIRE_MAX_DELAY && timing->t2 >= 1u &&
+           timing->t2 <= WS2812_WIRE_MAX_DELAY && timing->t3 >= 1u && timing->t3 <= WS2812_WIRE_MAX_DELAY &&
+           timing->bit_hz > 0.0f;
+}
+
+static uint16_t with_delay(uint16_t instr, uint cycles) {
+    return (uint16_t)((instr & ~WS2812_WIRE_DELAY_MASK) | ((cycles - 1u) << 8));
+}
+
+void ws2812_wire_program(const ws2812_wire_timing_t *timing, uint pin, uint32_t sys_hz,
+                         uint16_t instructions[PIO_INSTRUCTION_COUNT], pio_sm_config *config) {
+    memset(instructions, 0, PIO_INSTRUCTION_COUNT * sizeof(instructions[0]));
+    memcpy(instructions, ws2812_program_instructions, sizeof(ws2812_program_instructions));
+    instructions[WS2812_WIRE_OUT] = with_delay(instructions[WS2812_WIRE_OUT], timing->t3);
+    instructions[WS2812_WIRE_JMP_HIGH] = with_delay(instructions[WS2812_WIRE_JMP_HIGH], timing->t1);
+    instructions[WS2812_WIRE_JMP_ONE] = with_delay(instructions[WS2812_WIRE_JMP_ONE], timing->t2);
+    instructions[WS2812_WIRE_NOP_ZERO] = with_delay(instructions[WS2812_WIRE_NOP_ZERO], timing->t2);
+
+    *config = ws2812_program_get_default_config(0);
+    sm_config_set_sideset_pins(config, pin);
+    sm_config_set_out_shift(config, false, true, WS2812_WIRE_BITS_PER_PIXEL);
+    sm_config_set_fifo_join(config, PIO_FIFO_JOIN_TX);
+    uint cycles_per_bit = timing->t1 + timing->t2 + timing->t3;
+    sm_config_set_clkdiv(config, (float)sys_hz / (timing->bit_hz * (float)cycles_per_bit));
+}
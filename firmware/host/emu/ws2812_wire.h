@@ -0,0 +1,73 @@
+#ifndef WS2812_WIRE_H
+#define WS2812_WIRE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pio_emu.h"
+
+/*
+ * What a WS2812 sees on its data input: decodes a pulse train from
+ * pio_emu_run() back to GRB pixels and checks each pulse against the LED's
+ * timing windows, and builds the ws2812 program for other T1/T2/T3 sets so
+ * wire time and frame rate can be compared without a logic analyzer.
+ */
+
+typedef struct {
+    const char *name;
+    uint32_t t0h_min_ns;
+    uint32_t t0h_max_ns;
+    uint32_t t1h_min_ns;
+    uint32_t t1h_max_ns;
+    uint32_t bit_min_ns;
+    uint32_t bit_max_ns;
+    /* Low time that latches the frame. */
+    uint32_t reset_min_ns;
+} ws2812_wire_spec_t;
+
+/* WS2812B datasheet: T0H 0.4 us, T1H 0.8 us, bit 1.25 us, all +/-150 ns
+ * (bit +/-600 ns), reset >= 280 us on current parts. */
+extern const ws2812_wire_spec_t ws2812_wire_spec_ws2812b;
+
+typedef struct {
+    uint32_t bits;
+    uint32_t pixels;
+    uint32_t t0h_violations;
+    uint32_t t1h_violations;
+    uint32_t bit_violations;
+    /* Low gaps long enough to latch before the frame ended. */
+    uint32_t early_latches;
+    double t0h_ns;
+    double t1h_ns;
+    double bit_ns;
+    /* State machine start to the last bit's end, i.e. bits x bit time. */
+    double wire_ns;
+} ws2812_wire_report_t;
+
+/*
+ * Decode the pulses on `pin`: a bit is 1 if its high time is nearer T1H
+ * than T0H. Writes up to max_pixels 24-bit GRB values (the top 24 bits of
+ * the words pushed to the PIO) and fills report; t0h/t1h/bit are the
+ * longest seen.
+ */
+void ws2812_wire_decode(const pio_emu_edge_t *edges, const pio_emu_result_t *run, double cycle_ns, uint pin,
+                        const ws2812_wire_spec_t *spec, uint32_t *grb, uint32_t max_pixels,
+                        ws2812_wire_report_t *report);
+
+typedef struct {
+    uint t1;
+    uint t2;
+    uint t3;
+    float bit_hz;
+} ws2812_wire_timing_t;
+
+/* Delays are 4-bit with one side-set bit, so each T is 1..16 cycles. */
+bool ws2812_wire_timing_valid(const ws2812_wire_timing_t *timing);
+
+/*
+ * The ws2812 program at offset 0 with timing's delays patched in, and the
+ * configuration ws2812_program_init() would give it at sys_hz.
+ */
+void ws2812_wire_program(const ws2812_wire_timing_t *timing, uint pin, uint32_t sys_hz,
+                         uint16_t instructions[PIO_INSTRUCTION_COUNT], pio_sm_config *config);
+
+#endif
@@ -0,0 +1,478 @@
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <string.h>
+
+#include "btstack.h"
+#include "ble/att_db.h"
+#include "ble/att_server.h"
+#include "pico/stdlib.h"
+
+#include "host_sim.h"
+
+/*
+ * BTstack and the controller, reduced to what the firmware talks to. All
+ * callbacks into the firmware run with the BTstack lock held, which stands
+ * in for the background async context on the target: the run loop thread
+ * (timers and deferred controller events) and the driver's host_ble_*
+ * calls never overlap.
+ *
+ * The simulated central accepts connection parameter requests whose maximum
+ * is at least 15 ms, like iOS, and then uses max(min, 15 ms).
+ */
+
+#define HOST_CON_HANDLE 0x0040u
+#define HOST_CENTRAL_MIN_INTERVAL 12u
+#define HOST_SUPERVISION_TIMEOUT 400u
+#define HOST_RUN_LOOP_POLL_US 500u
+#define HOST_MAX_DEFERRED 16u
+#define HOST_MAX_EVENT_LEN 32u
+#define HOST_MAX_NOTIFY_LEN 512u
+#define HOST_MAX_WRITE_LEN 512u
+
+typedef enum {
+    TARGET_HCI = 0,
+    TARGET_ATT,
+    TARGET_L2CAP
+} event_target_t;
+
+typedef struct {
+    uint8_t packet[HOST_MAX_EVENT_LEN];
+    uint16_t size;
+    event_target_t target;
+    uint32_t at_ms;
+} deferred_event_t;
+
+static pthread_mutex_t btstack_lock;
+static pthread_once_t btstack_once = PTHREAD_ONCE_INIT;
+static pthread_t run_loop_thread;
+
+static btstack_linked_item_t *timers;
+static btstack_linked_item_t *hci_handlers;
+static btstack_linked_item_t *l2cap_handlers;
+static btstack_packet_handler_t att_handler;
+static att_read_callback_t att_read_callback;
+static att_write_callback_t att_write_callback;
+
+static deferred_event_t deferred[HOST_MAX_DEFERRED];
+static uint deferred_count = 0;
+
+static bool advertising = false;
+static bool connected = false;
+static uint16_t max_le_mtu = ATT_DEFAULT_MTU;
+static uint16_t mtu = ATT_DEFAULT_MTU;
+static uint16_t interval = 0;
+static uint16_t latency = 0;
+
+static uint32_t notifications = 0;
+static uint8_t last_notification[HOST_MAX_NOTIFY_LEN];
+static uint16_t last_notification_len = 0;
+static uint8_t write_buffer[HOST_MAX_WRITE_LEN];
+
+static void *run_loop_main(void *unused);
+
+static void btstack_init_once(void) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&btstack_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    pthread_create(&run_loop_thread, NULL, run_loop_main, NULL);
+}
+
+void host_btstack_lock(void) {
+    pthread_once(&btstack_once, btstack_init_once);
+    pthread_mutex_lock(&btstack_lock);
+}
+
+void host_btstack_unlock(void) {
+    pthread_mutex_unlock(&btstack_lock);
+}
+
+static void list_add(btstack_linked_item_t **list, btstack_linked_item_t *item) {
+    item->next = NULL;
+    while (*list) {
+        if (*list == item) {
+            return;
+        }
+        list = &(*list)->next;
+    }
+    *list = item;
+}
+
+static bool list_remove(btstack_linked_item_t **list, btstack_linked_item_t *item) {
+    for (; *list; list = &(*list)->next) {
+        if (*list == item) {
+            *list = item->next;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void dispatch(event_target_t target, uint8_t *packet, uint16_t size) {
+    if (target == TARGET_ATT) {
+        if (att_handler) {
+            att_handler(HCI_EVENT_PACKET, 0, packet, size);
+        }
+        return;
+    }
+    btstack_linked_item_t *item = target == TARGET_HCI ? hci_handlers : l2cap_handlers;
+    while (item) {
+        btstack_linked_item_t *next = item->next;
+        ((btstack_packet_callback_registration_t *)item)->callback(HCI_EVENT_PACKET, 0, packet, size);
+        item = next;
+    }
+}
+
+/* Deliver from the run loop one connection interval from now. */
+static void defer(event_target_t target, const uint8_t *packet, uint16_t size) {
+    if (deferred_count == HOST_MAX_DEFERRED || size > HOST_MAX_EVENT_LEN) {
+        return;
+    }
+    deferred_event_t *event = &deferred[deferred_count++];
+    memcpy(event->packet, packet, size);
+    event->size = size;
+    event->target = target;
+    event->at_ms = btstack_run_loop_get_time_ms() + (interval * 5u + 3u) / 4u;
+}
+
+static void run_deferred(void) {
+    uint32_t now = btstack_run_loop_get_time_ms();
+    for (uint i = 0; i < deferred_count;) {
+        if ((int32_t)(now - deferred[i].at_ms) < 0) {
+            ++i;
+            continue;
+        }
+        deferred_event_t event = deferred[i];
+        memmove(&deferred[i], &deferred[i + 1u], (deferred_count - i - 1u) * sizeof(deferred[0]));
+        deferred_count--;
+        if (connected) {
+            dispatch(event.target, event.packet, event.size);
+        }
+    }
+}
+
+static void run_timers(void) {
+    uint32_t now = btstack_run_loop_get_time_ms();
+    btstack_linked_item_t *item = timers;
+    while (item) {
+        btstack_timer_source_t *ts = (btstack_timer_source_t *)item;
+        item = item->next;
+        if ((int32_t)(now - ts->timeout) >= 0) {
+            list_remove(&timers, &ts->item);
+            ts->process(ts);
+            /* The handler may have changed the list; start over. */
+            item = timers;
+        }
+    }
+}
+
+static void *run_loop_main(void *unused) {
+    (void)unused;
+    host_set_core(0);
+    for (;;) {
+        host_btstack_lock();
+        run_deferred();
+        run_timers();
+        host_btstack_unlock();
+        sleep_us(HOST_RUN_LOOP_POLL_US);
+    }
+    return NULL;
+}
+
+/* ---- run loop ---- */
+
+uint32_t btstack_run_loop_get_time_ms(void) {
+    return (uint32_t)(time_us_64() / 1000u);
+}
+
+void btstack_run_loop_set_timer(btstack_timer_source_t *ts, uint32_t timeout_in_ms) {
+    ts->timeout = btstack_run_loop_get_time_ms() + timeout_in_ms;
+}
+
+void btstack_run_loop_set_timer_handler(btstack_timer_source_t *ts, void (*process)(btstack_timer_source_t *ts)) {
+    ts->process = process;
+}
+
+void btstack_run_loop_add_timer(btstack_timer_source_t *ts) {
+    host_btstack_lock();
+    list_add(&timers, &ts->item);
+    host_btstack_unlock();
+}
+
+int btstack_run_loop_remove_timer(btstack_timer_source_t *ts) {
+    host_btstack_lock();
+    bool removed = list_remove(&timers, &ts->item);
+    host_btstack_unlock();
+    return removed;
+}
+
+/* ---- HCI, L2CAP, SM ---- */
+
+void hci_add_event_handler(btstack_packet_callback_registration_t *callback_handler) {
+    host_btstack_lock();
+    list_add(&hci_handlers, &callback_handler->item);
+    host_btstack_unlock();
+}
+
+int hci_power_control(int power_mode) {
+    uint8_t event[3] = {BTSTACK_EVENT_STATE, 1, power_mode == HCI_POWER_ON ? HCI_STATE_WORKING : HCI_STATE_OFF};
+    host_btstack_lock();
+    dispatch(TARGET_HCI, event, sizeof(event));
+    host_btstack_unlock();
+    return 0;
+}
+
+void l2cap_init(void) {
+}
+
+void l2cap_add_event_handler(btstack_packet_callback_registration_t *callback_handler) {
+    host_btstack_lock();
+    list_add(&l2cap_handlers, &callback_handler->item);
+    host_btstack_unlock();
+}
+
+void l2cap_set_max_le_mtu(uint16_t max_mtu) {
+    max_le_mtu = max_mtu;
+}
+
+void sm_init(void) {
+}
+
+/* ---- GAP ---- */
+
+void gap_random_address_set(const bd_addr_t addr) {
+    (void)addr;
+}
+
+void gap_advertisements_set_params(uint16_t adv_int_min, uint16_t adv_int_max, uint8_t adv_type,
+                                   uint8_t direct_address_typ, bd_addr_t direct_address,
+                                   uint8_t channel_map, uint8_t filter_policy) {
+    (void)adv_int_min;
+    (void)adv_int_max;
+    (void)adv_type;
+    (void)direct_address_typ;
+    (void)direct_address;
+    (void)channel_map;
+    (void)filter_policy;
+}
+
+void gap_advertisements_set_data(uint8_t advertising_data_length, uint8_t *advertising_data) {
+    (void)advertising_data_length;
+    (void)advertising_data;
+}
+
+void gap_scan_response_set_data(uint8_t scan_response_data_length, uint8_t *scan_response_data) {
+    (void)scan_response_data_length;
+    (void)scan_response_data;
+}
+
+void gap_advertisements_enable(int enabled) {
+    advertising = enabled != 0;
+}
+
+int gap_request_connection_parameter_update(hci_con_handle_t con_handle, uint16_t conn_interval_min,
+                                            uint16_t conn_interval_max, uint16_t conn_latency,
+                                            uint16_t supervision_timeout) {
+    if (!connected || con_handle != HOST_CON_HANDLE) {
+        return ERROR_CODE_COMMAND_DISALLOWED;
+    }
+    bool accepted = conn_interval_max >= HOST_CENTRAL_MIN_INTERVAL;
+    uint8_t response[6] = {L2CAP_EVENT_CONNECTION_PARAMETER_UPDATE_RESPONSE, 4};
+    little_endian_store_16(response, 2, con_handle);
+    little_endian_store_16(response, 4, accepted ? 0 : 1);
+    defer(TARGET_L2CAP, response, sizeof(response));
+    if (!accepted) {
+        return ERROR_CODE_SUCCESS;
+    }
+    interval = conn_interval_min > HOST_CENTRAL_MIN_INTERVAL ? conn_interval_min : HOST_CENTRAL_MIN_INTERVAL;
+    latency = conn_latency;
+    uint8_t update[12] = {HCI_EVENT_LE_META, 10, HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE, ERROR_CODE_SUCCESS};
+    little_endian_store_16(update, 4, con_handle);
+    little_endian_store_16(update, 6, interval);
+    little_endian_store_16(update, 8, latency);
+    little_endian_store_16(update, 10, supervision_timeout);
+    defer(TARGET_HCI, update, sizeof(update));
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_le_set_phy(hci_con_handle_t con_handle, uint8_t all_phys, uint8_t tx_phys, uint8_t rx_phys,
+                       uint8_t phy_options) {
+    (void)all_phys;
+    (void)phy_options;
+    if (!connected) {
+        return ERROR_CODE_COMMAND_DISALLOWED;
+    }
+    uint8_t event[8] = {HCI_EVENT_LE_META, 6, HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE, ERROR_CODE_SUCCESS};
+    little_endian_store_16(event, 4, con_handle);
+    event[6] = (tx_phys & 0x02u) ? 2 : 1;
+    event[7] = (rx_phys & 0x02u) ? 2 : 1;
+    defer(TARGET_HCI, event, sizeof(event));
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_le_set_data_length(hci_con_handle_t con_handle, uint16_t tx_octets, uint16_t tx_time) {
+    if (!connected) {
+        return ERROR_CODE_COMMAND_DISALLOWED;
+    }
+    uint8_t event[13] = {HCI_EVENT_LE_META, 11, HCI_SUBEVENT_LE_DATA_LENGTH_CHANGE};
+    little_endian_store_16(event, 3, con_handle);
+    little_endian_store_16(event, 5, tx_octets);
+    little_endian_store_16(event, 7, tx_time);
+    little_endian_store_16(event, 9, tx_octets);
+    little_endian_store_16(event, 11, tx_time);
+    defer(TARGET_HCI, event, sizeof(event));
+    return ERROR_CODE_SUCCESS;
+}
+
+/* ---- ATT server ---- */
+
+void att_server_init(uint8_t const *db, att_read_callback_t read_callback, att_write_callback_t write_callback) {
+    (void)db;
+    att_read_callback = read_callback;
+    att_write_callback = write_callback;
+}
+
+void att_server_register_packet_handler(btstack_packet_handler_t handler) {
+    att_handler = handler;
+}
+
+int att_server_notify(hci_con_handle_t con_handle, uint16_t attribute_handle, const uint8_t *value,
+                      uint16_t value_len) {
+    (void)attribute_handle;
+    if (!connected || con_handle != HOST_CON_HANDLE || value_len > mtu - 3u) {
+        return ERROR_CODE_COMMAND_DISALLOWED;
+    }
+    notifications++;
+    last_notification_len = value_len < HOST_MAX_NOTIFY_LEN ? value_len : HOST_MAX_NOTIFY_LEN;
+    memcpy(last_notification, value, last_notification_len);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint16_t att_read_callback_handle_blob(const uint8_t *blob, uint16_t blob_size, uint16_t offset,
+                                       uint8_t *buffer, uint16_t buffer_size) {
+    if (offset > blob_size) {
+        return 0;
+    }
+    uint16_t len = (uint16_t)(blob_size - offset);
+    if (!buffer) {
+        return len;
+    }
+    if (len > buffer_size) {
+        len = buffer_size;
+    }
+    memcpy(buffer, blob + offset, len);
+    return len;
+}
+
+/* ---- driver side ---- */
+
+hci_con_handle_t host_ble_connect(uint16_t conn_interval) {
+    host_btstack_lock();
+    if (!connected) {
+        connected = true;
+        advertising = false;
+        mtu = ATT_DEFAULT_MTU;
+        interval = conn_interval;
+        latency = 0;
+
+        uint8_t complete[21] = {HCI_EVENT_LE_META, 19, HCI_SUBEVENT_LE_CONNECTION_COMPLETE, ERROR_CODE_SUCCESS};
+        little_endian_store_16(complete, 4, HOST_CON_HANDLE);
+        complete[6] = 1; /* we are the peripheral */
+        little_endian_store_16(complete, 14, interval);
+        little_endian_store_16(complete, 16, latency);
+        little_endian_store_16(complete, 18, HOST_SUPERVISION_TIMEOUT);
+        dispatch(TARGET_HCI, complete, sizeof(complete));
+
+        uint8_t att_connected[11] = {ATT_EVENT_CONNECTED, 9};
+        little_endian_store_16(att_connected, 9, HOST_CON_HANDLE);
+        dispatch(TARGET_ATT, att_connected, sizeof(att_connected));
+    }
+    host_btstack_unlock();
+    return HOST_CON_HANDLE;
+}
+
+void host_ble_disconnect(void) {
+    host_btstack_lock();
+    if (connected) {
+        connected = false;
+        deferred_count = 0;
+        uint8_t complete[6] = {HCI_EVENT_DISCONNECTION_COMPLETE, 4, ERROR_CODE_SUCCESS};
+        little_endian_store_16(complete, 3, HOST_CON_HANDLE);
+        complete[5] = ERROR_CODE_REMOTE_USER_TERMINATED_CONNECTION;
+        dispatch(TARGET_HCI, complete, sizeof(complete));
+
+        uint8_t att_disconnected[4] = {ATT_EVENT_DISCONNECTED, 2};
+        little_endian_store_16(att_disconnected, 2, HOST_CON_HANDLE);
+        dispatch(TARGET_ATT, att_disconnected, sizeof(att_disconnected));
+        mtu = ATT_DEFAULT_MTU;
+        interval = 0;
+    }
+    host_btstack_unlock();
+}
+
+uint16_t host_ble_exchange_mtu(uint16_t client_mtu) {
+    host_btstack_lock();
+    if (connected) {
+        mtu = client_mtu < max_le_mtu ? client_mtu : max_le_mtu;
+        if (mtu < ATT_DEFAULT_MTU) {
+            mtu = ATT_DEFAULT_MTU;
+        }
+        uint8_t event[6] = {ATT_EVENT_MTU_EXCHANGE_COMPLETE, 4};
+        little_endian_store_16(event, 2, HOST_CON_HANDLE);
+        little_endian_store_16(event, 4, mtu);
+        dispatch(TARGET_ATT, event, sizeof(event));
+    }
+    uint16_t agreed = mtu;
+    host_btstack_unlock();
+    return agreed;
+}
+
+int host_att_write(uint16_t attribute_handle, const uint8_t *data, uint16_t len) {
+    host_btstack_lock();
+    int result = -1;
+    if (connected && att_write_callback && len <= mtu - 3u && len <= sizeof(write_buffer)) {
+        memcpy(write_buffer, data, len);
+        result = att_write_callback(HOST_CON_HANDLE, attribute_handle, ATT_TRANSACTION_MODE_NONE, 0,
+                                    write_buffer, len);
+    }
+    host_btstack_unlock();
+    return result;
+}
+
+uint16_t host_att_read(uint16_t attribute_handle, uint16_t offset, uint8_t *buffer, uint16_t buffer_size) {
+    host_btstack_lock();
+    uint16_t len = 0;
+    if (connected && att_read_callback) {
+        len = att_read_callback(HOST_CON_HANDLE, attribute_handle, offset, buffer, buffer_size);
+    }
+    host_btstack_unlock();
+    return len;
+}
+
+uint16_t host_ble_mtu(void) {
+    return mtu;
+}
+
+uint16_t host_ble_interval(void) {
+    return interval;
+}
+
+bool host_ble_advertising(void) {
+    return advertising;
+}
+
+uint32_t host_ble_notifications(uint8_t *value, uint16_t max_len, uint16_t *len) {
+    host_btstack_lock();
+    uint32_t count = notifications;
+    if (value) {
+        uint16_t copy = last_notification_len < max_len ? last_notification_len : max_len;
+        memcpy(value, last_notification, copy);
+        if (len) {
+            *len = copy;
+        }
+    }
+    host_btstack_unlock();
+    return count;
+}
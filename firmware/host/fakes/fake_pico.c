@@ -0,0 +1,440 @@
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pico/cyw43_arch.h"
+#include "pico/multicore.h"
+#include "pico/rand.h"
+#include "pico/stdio_usb.h"
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/flash.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/watchdog.h"
+
+#include "host_sim.h"
+
+#define HOST_CLK_SYS_HZ 125000000u
+#define HOST_FIFO_DEPTH 8u
+#define HOST_MAX_EVENTS 64u
+#define HOST_MAX_IRQS 32u
+#define HOST_MAX_IRQ_HANDLERS 4u
+
+/* ---- time ---- */
+
+static uint64_t host_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static uint64_t boot_us;
+
+__attribute__((constructor)) static void host_boot(void) {
+    boot_us = host_now_us();
+}
+
+uint64_t time_us_64(void) {
+    return host_now_us() - boot_us;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+void sleep_us(uint64_t us) {
+    struct timespec ts = {(time_t)(us / 1000000u), (long)(us % 1000000u) * 1000L};
+    while (nanosleep(&ts, &ts) != 0) {
+    }
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000u);
+}
+
+void tight_loop_contents(void) {
+    sched_yield();
+}
+
+static void deadline_to_timespec(uint64_t at_us, struct timespec *ts) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t now_us = time_us_64();
+    uint64_t wait_us = at_us > now_us ? at_us - now_us : 0;
+    uint64_t nsec = (uint64_t)now.tv_nsec + (wait_us % 1000000u) * 1000u;
+    ts->tv_sec = now.tv_sec + (time_t)(wait_us / 1000000u) + (time_t)(nsec / 1000000000u);
+    ts->tv_nsec = (long)(nsec % 1000000000u);
+}
+
+/* ---- cores and interrupts ---- */
+
+static _Thread_local uint current_core = 0;
+static pthread_mutex_t irq_lock;
+static pthread_once_t irq_lock_once = PTHREAD_ONCE_INIT;
+
+static void irq_lock_init(void) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&irq_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+void host_set_core(uint core) {
+    current_core = core;
+}
+
+uint get_core_num(void) {
+    return current_core;
+}
+
+uint32_t save_and_disable_interrupts(void) {
+    pthread_once(&irq_lock_once, irq_lock_init);
+    pthread_mutex_lock(&irq_lock);
+    return 0;
+}
+
+void restore_interrupts(uint32_t status) {
+    (void)status;
+    pthread_mutex_unlock(&irq_lock);
+}
+
+typedef struct {
+    irq_handler_t handlers[HOST_MAX_IRQ_HANDLERS];
+    uint count;
+    bool enabled;
+} host_irq_t;
+
+static host_irq_t irqs[HOST_MAX_IRQS];
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority) {
+    (void)order_priority;
+    if (num < HOST_MAX_IRQS && irqs[num].count < HOST_MAX_IRQ_HANDLERS) {
+        irqs[num].handlers[irqs[num].count++] = handler;
+    }
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+    if (num < HOST_MAX_IRQS) {
+        irqs[num].handlers[0] = handler;
+        irqs[num].count = 1;
+    }
+}
+
+void irq_set_enabled(uint num, bool enabled) {
+    if (num < HOST_MAX_IRQS) {
+        irqs[num].enabled = enabled;
+    }
+}
+
+void host_irq_dispatch(uint num) {
+    if (num >= HOST_MAX_IRQS || !irqs[num].enabled) {
+        return;
+    }
+    for (uint i = 0; i < irqs[num].count; ++i) {
+        irqs[num].handlers[i]();
+    }
+}
+
+/* ---- simulated IRQ thread: alarms and peripheral completions ---- */
+
+typedef struct {
+    uint64_t at_us;
+    uint core;
+    void (*fn)(void *arg);
+    void *arg;
+    alarm_callback_t alarm;
+    alarm_id_t alarm_id;
+} host_event_t;
+
+static host_event_t events[HOST_MAX_EVENTS];
+static uint event_count = 0;
+static alarm_id_t next_alarm_id = 1;
+static pthread_mutex_t event_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t event_cond = PTHREAD_COND_INITIALIZER;
+static pthread_once_t event_thread_once = PTHREAD_ONCE_INIT;
+static pthread_t event_thread;
+
+static void *event_thread_main(void *unused);
+
+static void start_event_thread(void) {
+    pthread_create(&event_thread, NULL, event_thread_main, NULL);
+}
+
+static alarm_id_t queue_event(const host_event_t *event) {
+    pthread_once(&event_thread_once, start_event_thread);
+    pthread_mutex_lock(&event_lock);
+    if (event_count == HOST_MAX_EVENTS) {
+        pthread_mutex_unlock(&event_lock);
+        return -1;
+    }
+    events[event_count] = *event;
+    alarm_id_t id = events[event_count].alarm_id;
+    event_count++;
+    pthread_cond_signal(&event_cond);
+    pthread_mutex_unlock(&event_lock);
+    return id;
+}
+
+static void *event_thread_main(void *unused) {
+    (void)unused;
+    pthread_mutex_lock(&event_lock);
+    for (;;) {
+        uint next = HOST_MAX_EVENTS;
+        for (uint i = 0; i < event_count; ++i) {
+            if (next == HOST_MAX_EVENTS || events[i].at_us < events[next].at_us) {
+                next = i;
+            }
+        }
+        if (next == HOST_MAX_EVENTS) {
+            pthread_cond_wait(&event_cond, &event_lock);
+            continue;
+        }
+        if (events[next].at_us > time_us_64()) {
+            struct timespec deadline;
+            deadline_to_timespec(events[next].at_us, &deadline);
+            pthread_cond_timedwait(&event_cond, &event_lock, &deadline);
+            continue;
+        }
+        host_event_t event = events[next];
+        events[next] = events[--event_count];
+        pthread_mutex_unlock(&event_lock);
+
+        current_core = event.core;
+        uint32_t irq_state = save_and_disable_interrupts();
+        if (event.alarm) {
+            int64_t again = event.alarm(event.alarm_id, event.arg);
+            if (again != 0) {
+                event.at_us = again > 0 ? time_us_64() + (uint64_t)again : event.at_us + (uint64_t)-again;
+                queue_event(&event);
+            }
+        } else {
+            event.fn(event.arg);
+        }
+        restore_interrupts(irq_state);
+
+        pthread_mutex_lock(&event_lock);
+    }
+    return NULL;
+}
+
+void host_schedule_at(uint64_t at_us, uint core, void (*fn)(void *arg), void *arg) {
+    host_event_t event = {.at_us = at_us, .core = core, .fn = fn, .arg = arg};
+    queue_event(&event);
+}
+
+struct alarm_pool {
+    uint max_timers;
+};
+
+static alarm_pool_t alarm_pools[4];
+static uint alarm_pool_count = 0;
+static alarm_pool_t default_alarm_pool = {16};
+
+alarm_pool_t *alarm_pool_create_with_unused_hardware_alarm(uint max_timers) {
+    if (alarm_pool_count == count_of(alarm_pools)) {
+        return NULL;
+    }
+    alarm_pools[alarm_pool_count].max_timers = max_timers;
+    return &alarm_pools[alarm_pool_count++];
+}
+
+alarm_id_t alarm_pool_add_alarm_in_us(alarm_pool_t *pool, uint64_t us, alarm_callback_t callback,
+                                      void *user_data, bool fire_if_past) {
+    (void)pool;
+    (void)fire_if_past;
+    pthread_mutex_lock(&event_lock);
+    alarm_id_t id = next_alarm_id++;
+    pthread_mutex_unlock(&event_lock);
+    host_event_t event = {
+        .at_us = time_us_64() + us,
+        .core = current_core,
+        .arg = user_data,
+        .alarm = callback,
+        .alarm_id = id,
+    };
+    return queue_event(&event);
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return alarm_pool_add_alarm_in_us(&default_alarm_pool, us, callback, user_data, fire_if_past);
+}
+
+/* ---- multicore ---- */
+
+typedef struct {
+    uint32_t data[HOST_FIFO_DEPTH];
+    uint head;
+    uint count;
+} host_fifo_t;
+
+/* fifos[n] is read by core n. */
+static host_fifo_t fifos[2];
+static pthread_mutex_t fifo_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t fifo_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t core1_thread;
+
+static void *core1_thread_main(void *entry) {
+    current_core = 1;
+    ((void (*)(void))entry)();
+    return NULL;
+}
+
+void multicore_launch_core1(void (*entry)(void)) {
+    pthread_create(&core1_thread, NULL, core1_thread_main, (void *)entry);
+}
+
+/* Core1 keeps running: only the flash writes that follow this need it
+ * stopped, and on the host they do not disturb it. */
+void multicore_reset_core1(void) {
+}
+
+bool multicore_fifo_rvalid(void) {
+    pthread_mutex_lock(&fifo_lock);
+    bool valid = fifos[current_core].count > 0;
+    pthread_mutex_unlock(&fifo_lock);
+    return valid;
+}
+
+bool multicore_fifo_wready(void) {
+    pthread_mutex_lock(&fifo_lock);
+    bool ready = fifos[current_core ^ 1u].count < HOST_FIFO_DEPTH;
+    pthread_mutex_unlock(&fifo_lock);
+    return ready;
+}
+
+void multicore_fifo_push_blocking(uint32_t data) {
+    host_fifo_t *fifo = &fifos[current_core ^ 1u];
+    pthread_mutex_lock(&fifo_lock);
+    while (fifo->count == HOST_FIFO_DEPTH) {
+        pthread_cond_wait(&fifo_cond, &fifo_lock);
+    }
+    fifo->data[(fifo->head + fifo->count) % HOST_FIFO_DEPTH] = data;
+    fifo->count++;
+    pthread_cond_broadcast(&fifo_cond);
+    pthread_mutex_unlock(&fifo_lock);
+}
+
+static uint32_t fifo_pop_locked(host_fifo_t *fifo) {
+    uint32_t data = fifo->data[fifo->head];
+    fifo->head = (fifo->head + 1u) % HOST_FIFO_DEPTH;
+    fifo->count--;
+    pthread_cond_broadcast(&fifo_cond);
+    return data;
+}
+
+uint32_t multicore_fifo_pop_blocking(void) {
+    host_fifo_t *fifo = &fifos[current_core];
+    pthread_mutex_lock(&fifo_lock);
+    while (fifo->count == 0) {
+        pthread_cond_wait(&fifo_cond, &fifo_lock);
+    }
+    uint32_t data = fifo_pop_locked(fifo);
+    pthread_mutex_unlock(&fifo_lock);
+    return data;
+}
+
+bool multicore_fifo_pop_timeout_us(uint64_t timeout_us, uint32_t *out) {
+    host_fifo_t *fifo = &fifos[current_core];
+    uint64_t deadline_us = time_us_64() + timeout_us;
+    struct timespec deadline;
+    deadline_to_timespec(deadline_us, &deadline);
+    pthread_mutex_lock(&fifo_lock);
+    while (fifo->count == 0 && time_us_64() < deadline_us) {
+        pthread_cond_timedwait(&fifo_cond, &fifo_lock, &deadline);
+    }
+    bool popped = fifo->count > 0;
+    if (popped) {
+        *out = fifo_pop_locked(fifo);
+    }
+    pthread_mutex_unlock(&fifo_lock);
+    return popped;
+}
+
+void multicore_fifo_drain(void) {
+    host_fifo_t *fifo = &fifos[current_core];
+    pthread_mutex_lock(&fifo_lock);
+    while (fifo->count > 0) {
+        fifo_pop_locked(fifo);
+    }
+    pthread_mutex_unlock(&fifo_lock);
+}
+
+/* ---- the rest of the platform ---- */
+
+bool stdio_init_all(void) {
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    return true;
+}
+
+bool stdio_usb_connected(void) {
+    return true;
+}
+
+int getchar_timeout_us(uint32_t timeout_us) {
+    (void)timeout_us;
+    return PICO_ERROR_TIMEOUT;
+}
+
+uint32_t get_rand_32(void) {
+    static uint32_t state = 0x50534c31u;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+uint32_t clock_get_hz(enum clock_index clk_index) {
+    (void)clk_index;
+    return HOST_CLK_SYS_HZ;
+}
+
+int cyw43_arch_init(void) {
+    return 0;
+}
+
+void cyw43_arch_deinit(void) {
+}
+
+/* Erased; strip_config_load() falls back to its defaults. */
+uint8_t host_flash_image[PICO_FLASH_SIZE_BYTES];
+
+__attribute__((constructor)) static void host_flash_erase_all(void) {
+    memset(host_flash_image, 0xff, sizeof(host_flash_image));
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    if (flash_offs % FLASH_SECTOR_SIZE || count % FLASH_SECTOR_SIZE || flash_offs + count > PICO_FLASH_SIZE_BYTES) {
+        fprintf(stderr, "flash_range_erase: bad range %u+%zu\n", (unsigned)flash_offs, count);
+        abort();
+    }
+    memset(&host_flash_image[flash_offs], 0xff, count);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    if (flash_offs % FLASH_PAGE_SIZE || count % FLASH_PAGE_SIZE || flash_offs + count > PICO_FLASH_SIZE_BYTES) {
+        fprintf(stderr, "flash_range_program: bad range %u+%zu\n", (unsigned)flash_offs, count);
+        abort();
+    }
+    for (size_t i = 0; i < count; ++i) {
+        host_flash_image[flash_offs + i] &= data[i];
+    }
+}
+
+static volatile bool reboot_requested = false;
+
+void watchdog_reboot(uint32_t pc, uint32_t sp, uint32_t delay_ms) {
+    (void)pc;
+    (void)sp;
+    (void)delay_ms;
+    reboot_requested = true;
+}
+
+bool host_reboot_requested(void) {
+    return reboot_requested;
+}
@@ -0,0 +1,407 @@
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <string.h>
+
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+
+#include "host_sim.h"
+
+/* DREQ numbering as on the RP2040: PIO0 TX0..3, RX0..3, then PIO1. */
+#define HOST_DREQ_PIO_STRIDE 8u
+#define HOST_DMA_IRQ_COUNT 2u
+/* Cycles per loop of the WS2812 programs (T1 + T2 + T3), used to pace DMA. */
+#define HOST_PIO_CYCLES_PER_LOOP 10u
+
+pio_hw_t pio0_hw_inst;
+pio_hw_t pio1_hw_inst;
+
+typedef struct {
+    uint32_t words[HOST_PIO_MAX_FRAME_WORDS];
+    uint32_t len;
+} host_frame_t;
+
+typedef struct {
+    bool claimed;
+    bool configured;
+    bool enabled;
+    uint initial_pc;
+    pio_sm_config config;
+    host_frame_t pending;
+    host_frame_t last;
+    /* Every frame laid over the ones before, as the LEDs latch them. */
+    host_frame_t shown;
+    uint32_t frames;
+} host_sm_t;
+
+typedef struct {
+    uint16_t instructions[PIO_INSTRUCTION_COUNT];
+    uint32_t used_mask;
+    host_sm_t sm[NUM_PIO_STATE_MACHINES];
+} host_pio_t;
+
+static host_pio_t pios[NUM_PIOS];
+static pthread_mutex_t recorder_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t recorder_cond = PTHREAD_COND_INITIALIZER;
+
+uint pio_get_index(PIO pio) {
+    return pio == pio1 ? 1u : 0u;
+}
+
+PIO pio_get_instance(uint instance) {
+    return instance == 1u ? pio1 : pio0;
+}
+
+static host_sm_t *host_sm(PIO pio, uint sm) {
+    return &pios[pio_get_index(pio)].sm[sm % NUM_PIO_STATE_MACHINES];
+}
+
+/* Highest free offset the program fits at, or -1. */
+static int find_program_offset(const host_pio_t *p, const pio_program_t *program) {
+    uint32_t mask = program->length >= 32u ? UINT32_MAX : (1u << program->length) - 1u;
+    if (program->origin >= 0) {
+        return (p->used_mask & (mask << program->origin)) ? -1 : program->origin;
+    }
+    for (int offset = (int)(PIO_INSTRUCTION_COUNT - program->length); offset >= 0; --offset) {
+        if (!(p->used_mask & (mask << offset))) {
+            return offset;
+        }
+    }
+    return -1;
+}
+
+bool pio_can_add_program(PIO pio, const pio_program_t *program) {
+    return find_program_offset(&pios[pio_get_index(pio)], program) >= 0;
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *program) {
+    host_pio_t *p = &pios[pio_get_index(pio)];
+    uint32_t mask = program->length >= 32u ? UINT32_MAX : (1u << program->length) - 1u;
+    int offset = find_program_offset(p, program);
+    if (offset < 0) {
+        return 0;
+    }
+    for (uint i = 0; i < program->length; ++i) {
+        uint16_t instr = program->instructions[i];
+        /* JMP targets are program-relative; relocate them as the SDK does. */
+        if ((instr & 0xe000u) == 0) {
+            instr = (uint16_t)(instr + offset);
+        }
+        p->instructions[(uint)offset + i] = instr;
+    }
+    p->used_mask |= mask << offset;
+    return (uint)offset;
+}
+
+int pio_claim_unused_sm(PIO pio, bool required) {
+    (void)required;
+    for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; ++sm) {
+        if (!host_sm(pio, sm)->claimed) {
+            host_sm(pio, sm)->claimed = true;
+            return (int)sm;
+        }
+    }
+    return -1;
+}
+
+void pio_sm_claim(PIO pio, uint sm) {
+    host_sm(pio, sm)->claimed = true;
+}
+
+void pio_sm_unclaim(PIO pio, uint sm) {
+    host_sm(pio, sm)->claimed = false;
+    host_sm(pio, sm)->configured = false;
+}
+
+bool pio_sm_is_claimed(PIO pio, uint sm) {
+    return host_sm(pio, sm)->claimed;
+}
+
+void pio_gpio_init(PIO pio, uint pin) {
+    (void)pio;
+    (void)pin;
+}
+
+int pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out) {
+    (void)pio;
+    (void)sm;
+    (void)pin_base;
+    (void)pin_count;
+    (void)is_out;
+    return 0;
+}
+
+int pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config) {
+    host_sm_t *state = host_sm(pio, sm);
+    pthread_mutex_lock(&recorder_lock);
+    state->config = config ? *config : pio_get_default_sm_config();
+    state->initial_pc = initial_pc;
+    state->configured = true;
+    state->enabled = false;
+    state->pending.len = 0;
+    pthread_mutex_unlock(&recorder_lock);
+    return 0;
+}
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) {
+    host_sm(pio, sm)->enabled = enabled;
+}
+
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx) {
+    return pio_get_index(pio) * HOST_DREQ_PIO_STRIDE + (is_tx ? 0u : NUM_PIO_STATE_MACHINES) + sm;
+}
+
+void host_pio_record_words(PIO pio, uint sm, const uint32_t *words, uint32_t count, bool end_frame) {
+    host_sm_t *state = host_sm(pio, sm);
+    pthread_mutex_lock(&recorder_lock);
+    uint32_t room = HOST_PIO_MAX_FRAME_WORDS - state->pending.len;
+    if (count > room) {
+        count = room;
+    }
+    if (count) {
+        memcpy(&state->pending.words[state->pending.len], words, count * sizeof(uint32_t));
+        state->pending.len += count;
+    }
+    if (end_frame) {
+        memcpy(state->shown.words, state->pending.words, state->pending.len * sizeof(uint32_t));
+        if (state->pending.len > state->shown.len) {
+            state->shown.len = state->pending.len;
+        }
+        state->last = state->pending;
+        state->pending.len = 0;
+        state->frames++;
+        pthread_cond_broadcast(&recorder_cond);
+    }
+    pthread_mutex_unlock(&recorder_lock);
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data) {
+    host_pio_record_words(pio, sm, &data, 1, false);
+    sleep_us(host_pio_word_time_ns(pio, sm) / 1000u);
+}
+
+/* Bits the loop's OUT shifts: 1 for ws2812.pio, 32 for ws2812_parallel.pio. */
+static uint out_bits_per_loop(PIO pio, const pio_sm_config *config) {
+    const uint16_t *instructions = pios[pio_get_index(pio)].instructions;
+    for (uint pc = config->wrap_target; pc <= config->wrap; ++pc) {
+        if ((instructions[pc] >> 13) == 3u) {
+            uint bits = instructions[pc] & 0x1fu;
+            return bits ? bits : 32u;
+        }
+    }
+    return 1u;
+}
+
+uint64_t host_pio_word_time_ns(PIO pio, uint sm) {
+    const pio_sm_config *config = &host_sm(pio, sm)->config;
+    double cycle_ns = 1e9 * (double)config->clkdiv / (double)clock_get_hz(clk_sys);
+    uint loops = (config->pull_threshold + out_bits_per_loop(pio, config) - 1u) / out_bits_per_loop(pio, config);
+    return (uint64_t)(cycle_ns * HOST_PIO_CYCLES_PER_LOOP * (double)loops);
+}
+
+uint32_t host_pio_frame_count(PIO pio, uint sm) {
+    pthread_mutex_lock(&recorder_lock);
+    uint32_t frames = host_sm(pio, sm)->frames;
+    pthread_mutex_unlock(&recorder_lock);
+    return frames;
+}
+
+uint32_t host_pio_last_frame(PIO pio, uint sm, uint32_t *words, uint32_t max_words) {
+    pthread_mutex_lock(&recorder_lock);
+    const host_frame_t *frame = &host_sm(pio, sm)->last;
+    uint32_t len = frame->len < max_words ? frame->len : max_words;
+    memcpy(words, frame->words, len * sizeof(uint32_t));
+    pthread_mutex_unlock(&recorder_lock);
+    return len;
+}
+
+uint32_t host_pio_shown_frame(PIO pio, uint sm, uint32_t *words, uint32_t max_words) {
+    pthread_mutex_lock(&recorder_lock);
+    const host_frame_t *frame = &host_sm(pio, sm)->shown;
+    uint32_t len = frame->len < max_words ? frame->len : max_words;
+    memcpy(words, frame->words, len * sizeof(uint32_t));
+    pthread_mutex_unlock(&recorder_lock);
+    return len;
+}
+
+bool host_pio_wait_frames(PIO pio, uint sm, uint32_t count, uint32_t timeout_ms) {
+    uint64_t deadline_us = time_us_64() + (uint64_t)timeout_ms * 1000u;
+    while (host_pio_frame_count(pio, sm) <= count) {
+        if (time_us_64() >= deadline_us) {
+            return false;
+        }
+        sleep_us(100);
+    }
+    return true;
+}
+
+bool host_pio_sm_config(PIO pio, uint sm, pio_sm_config *config, uint *initial_pc) {
+    const host_sm_t *state = host_sm(pio, sm);
+    if (!state->configured) {
+        return false;
+    }
+    *config = state->config;
+    *initial_pc = state->initial_pc;
+    return true;
+}
+
+const uint16_t *host_pio_instructions(PIO pio) {
+    return pios[pio_get_index(pio)].instructions;
+}
+
+uint host_pio_configured_sms(PIO *pio_out, uint *sm_out, uint max) {
+    const PIO blocks[NUM_PIOS] = {pio0, pio1};
+    uint count = 0;
+    for (uint p = 0; p < NUM_PIOS; ++p) {
+        for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES && count < max; ++sm) {
+            if (pios[p].sm[sm].configured) {
+                pio_out[count] = blocks[p];
+                sm_out[count] = sm;
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+/* ---- DMA ---- */
+
+typedef struct {
+    bool claimed;
+    bool busy;
+    dma_channel_config config;
+    volatile void *write_addr;
+    const volatile void *read_addr;
+    uint32_t transfer_count;
+    bool irq_enabled[HOST_DMA_IRQ_COUNT];
+    bool irq_status[HOST_DMA_IRQ_COUNT];
+} host_dma_t;
+
+static host_dma_t dma_channels[NUM_DMA_CHANNELS];
+
+int dma_claim_unused_channel(bool required) {
+    (void)required;
+    for (uint i = 0; i < NUM_DMA_CHANNELS; ++i) {
+        if (!dma_channels[i].claimed) {
+            dma_channels[i].claimed = true;
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+void dma_channel_unclaim(uint channel) {
+    dma_channels[channel].claimed = false;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    (void)channel;
+    dma_channel_config c = {DMA_SIZE_32, true, false, 0x3fu};
+    return c;
+}
+
+static bool pio_target(volatile void *addr, PIO *pio, uint *sm) {
+    PIO candidates[NUM_PIOS] = {pio0, pio1};
+    for (uint p = 0; p < NUM_PIOS; ++p) {
+        for (uint s = 0; s < NUM_PIO_STATE_MACHINES; ++s) {
+            if (addr == (volatile void *)&candidates[p]->txf[s]) {
+                *pio = candidates[p];
+                *sm = s;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/* A transfer restarted from the completion IRQ continues the same frame,
+ * as the FIFO never runs dry; otherwise the frame ends here. */
+static void dma_complete(void *arg) {
+    uint channel = (uint)(uintptr_t)arg;
+    host_dma_t *dma = &dma_channels[channel];
+    dma->busy = false;
+    for (uint irq = 0; irq < HOST_DMA_IRQ_COUNT; ++irq) {
+        if (dma->irq_enabled[irq]) {
+            dma->irq_status[irq] = true;
+            host_irq_dispatch(DMA_IRQ_0 + irq);
+        }
+    }
+    PIO pio;
+    uint sm;
+    if (!dma->busy && pio_target(dma->write_addr, &pio, &sm)) {
+        host_pio_record_words(pio, sm, NULL, 0, true);
+    }
+}
+
+static void dma_start(uint channel) {
+    host_dma_t *dma = &dma_channels[channel];
+    PIO pio;
+    uint sm;
+    uint64_t duration_us = 0;
+    if (pio_target(dma->write_addr, &pio, &sm) && dma->config.size == DMA_SIZE_32) {
+        /* The words are captured up front; the CPU must not touch a buffer in flight anyway. */
+        host_pio_record_words(pio, sm, (const uint32_t *)dma->read_addr, dma->transfer_count, false);
+        duration_us = (host_pio_word_time_ns(pio, sm) * dma->transfer_count) / 1000u;
+    }
+    dma->busy = true;
+    host_schedule_at(time_us_64() + duration_us, get_core_num(), dma_complete, (void *)(uintptr_t)channel);
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger) {
+    host_dma_t *dma = &dma_channels[channel];
+    dma->config = *config;
+    dma->write_addr = write_addr;
+    dma->read_addr = read_addr;
+    dma->transfer_count = transfer_count;
+    if (trigger) {
+        dma_start(channel);
+    }
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger) {
+    dma_channels[channel].read_addr = read_addr;
+    if (trigger) {
+        dma_start(channel);
+    }
+}
+
+void dma_channel_set_trans_count(uint channel, uint32_t transfer_count, bool trigger) {
+    dma_channels[channel].transfer_count = transfer_count;
+    if (trigger) {
+        dma_start(channel);
+    }
+}
+
+void dma_start_channel_mask(uint32_t chan_mask) {
+    for (uint i = 0; i < NUM_DMA_CHANNELS; ++i) {
+        if (chan_mask & (1u << i)) {
+            dma_start(i);
+        }
+    }
+}
+
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count) {
+    dma_channels[channel].read_addr = read_addr;
+    dma_channels[channel].transfer_count = transfer_count;
+    dma_start(channel);
+}
+
+bool dma_channel_is_busy(uint channel) {
+    return dma_channels[channel].busy;
+}
+
+void dma_irqn_set_channel_enabled(uint irq_index, uint channel, bool enabled) {
+    dma_channels[channel].irq_enabled[irq_index] = enabled;
+}
+
+bool dma_irqn_get_channel_status(uint irq_index, uint channel) {
+    return dma_channels[channel].irq_status[irq_index];
+}
+
+void dma_irqn_acknowledge_channel(uint irq_index, uint channel) {
+    dma_channels[channel].irq_status[irq_index] = false;
+}
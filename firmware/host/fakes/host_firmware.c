@@ -0,0 +1,36 @@
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "pico/stdlib.h"
+#include "host_sim.h"
+
+#define HOST_BOOT_TIMEOUT_MS 5000u
+
+/* src/main.c's main(), renamed by the host build. */
+int psl_firmware_main(void);
+
+static pthread_t core0_thread;
+
+static void *core0_thread_main(void *unused) {
+    (void)unused;
+    host_set_core(0);
+    exit(psl_firmware_main());
+}
+
+void host_firmware_start(void) {
+    pthread_create(&core0_thread, NULL, core0_thread_main, NULL);
+    uint64_t deadline_us = time_us_64() + HOST_BOOT_TIMEOUT_MS * 1000u;
+    while (!host_ble_advertising()) {
+        if (time_us_64() >= deadline_us) {
+            fprintf(stderr, "host: firmware did not start advertising\n");
+            exit(1);
+        }
+        sleep_ms(1);
+    }
+}
+
+void host_sleep_ms(uint32_t ms) {
+    sleep_ms(ms);
+}
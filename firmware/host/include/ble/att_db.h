@@ -0,0 +1,9 @@
+#ifndef HOST_BLE_ATT_DB_H
+#define HOST_BLE_ATT_DB_H
+
+#include "btstack.h"
+
+uint16_t att_read_callback_handle_blob(const uint8_t *blob, uint16_t blob_size, uint16_t offset,
+                                       uint8_t *buffer, uint16_t buffer_size);
+
+#endif
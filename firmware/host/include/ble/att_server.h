@@ -0,0 +1,17 @@
+#ifndef HOST_BLE_ATT_SERVER_H
+#define HOST_BLE_ATT_SERVER_H
+
+#include "btstack.h"
+
+typedef uint16_t (*att_read_callback_t)(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t offset,
+                                        uint8_t *buffer, uint16_t buffer_size);
+typedef int (*att_write_callback_t)(hci_con_handle_t con_handle, uint16_t attribute_handle,
+                                    uint16_t transaction_mode, uint16_t offset, uint8_t *buffer,
+                                    uint16_t buffer_size);
+
+void att_server_init(uint8_t const *db, att_read_callback_t read_callback, att_write_callback_t write_callback);
+void att_server_register_packet_handler(btstack_packet_handler_t handler);
+int att_server_notify(hci_con_handle_t con_handle, uint16_t attribute_handle, const uint8_t *value,
+                      uint16_t value_len);
+
+#endif
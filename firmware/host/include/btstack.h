@@ -0,0 +1,116 @@
+#ifndef HOST_BTSTACK_H
+#define HOST_BTSTACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * The slice of BTstack the firmware uses, backed by fakes/fake_btstack.c.
+ * Constants and event layouts match BTstack so the firmware's parsing is
+ * exercised unchanged; the controller side is driven through host_sim.h.
+ */
+
+typedef uint8_t bd_addr_t[6];
+typedef uint16_t hci_con_handle_t;
+#define HCI_CON_HANDLE_INVALID 0xffff
+
+typedef void (*btstack_packet_handler_t)(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
+
+typedef struct btstack_linked_item {
+    struct btstack_linked_item *next;
+} btstack_linked_item_t;
+
+typedef struct {
+    btstack_linked_item_t item;
+    btstack_packet_handler_t callback;
+} btstack_packet_callback_registration_t;
+
+typedef struct btstack_timer_source {
+    btstack_linked_item_t item;
+    uint32_t timeout;
+    void (*process)(struct btstack_timer_source *ts);
+    void *context;
+} btstack_timer_source_t;
+
+void btstack_run_loop_set_timer(btstack_timer_source_t *ts, uint32_t timeout_in_ms);
+void btstack_run_loop_set_timer_handler(btstack_timer_source_t *ts, void (*process)(btstack_timer_source_t *ts));
+void btstack_run_loop_add_timer(btstack_timer_source_t *ts);
+int btstack_run_loop_remove_timer(btstack_timer_source_t *ts);
+uint32_t btstack_run_loop_get_time_ms(void);
+
+#define HCI_POWER_OFF 0
+#define HCI_POWER_ON 1
+#define HCI_STATE_OFF 0
+#define HCI_STATE_WORKING 2
+
+#define HCI_EVENT_PACKET 0x04
+#define ATT_DATA_PACKET 0x08
+
+#define ERROR_CODE_SUCCESS 0x00
+#define ERROR_CODE_COMMAND_DISALLOWED 0x0c
+#define ERROR_CODE_REMOTE_USER_TERMINATED_CONNECTION 0x13
+
+#define HCI_EVENT_DISCONNECTION_COMPLETE 0x05
+#define HCI_EVENT_LE_META 0x3e
+#define HCI_SUBEVENT_LE_CONNECTION_COMPLETE 0x01
+#define HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE 0x03
+#define HCI_SUBEVENT_LE_DATA_LENGTH_CHANGE 0x07
+#define HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE 0x0c
+#define BTSTACK_EVENT_STATE 0x60
+#define L2CAP_EVENT_CONNECTION_PARAMETER_UPDATE_RESPONSE 0x77
+#define ATT_EVENT_CONNECTED 0xb3
+#define ATT_EVENT_DISCONNECTED 0xb4
+#define ATT_EVENT_MTU_EXCHANGE_COMPLETE 0xb5
+#define ATT_EVENT_CAN_SEND_NOW 0xb7
+
+#define BLUETOOTH_DATA_TYPE_FLAGS 0x01
+#define BLUETOOTH_DATA_TYPE_COMPLETE_LIST_OF_128_BIT_SERVICE_CLASS_UUIDS 0x07
+#define BLUETOOTH_DATA_TYPE_COMPLETE_LOCAL_NAME 0x09
+
+#define ATT_EXCHANGE_MTU_REQUEST 0x02
+#define ATT_EXCHANGE_MTU_RESPONSE 0x03
+#define ATT_READ_BY_TYPE_REQUEST 0x08
+#define ATT_READ_REQUEST 0x0a
+#define ATT_READ_BLOB_REQUEST 0x0c
+#define ATT_READ_MULTIPLE_REQUEST 0x0e
+#define ATT_READ_BY_GROUP_TYPE_REQUEST 0x10
+#define ATT_WRITE_REQUEST 0x12
+#define ATT_READ_MULTIPLE_VARIABLE_REQ 0x20
+#define ATT_WRITE_COMMAND 0x52
+#define ATT_SIGNED_WRITE_COMMAND 0xd2
+
+#define ATT_ERROR_ATTRIBUTE_NOT_FOUND 0x0a
+#define ATT_ERROR_INVALID_ATTRIBUTE_VALUE_LENGTH 0x0d
+#define ATT_ERROR_INSUFFICIENT_RESOURCES 0x11
+#define ATT_ERROR_VALUE_NOT_ALLOWED 0x13
+#define ATT_TRANSACTION_MODE_NONE 0x0
+#define ATT_DEFAULT_MTU 23u
+
+#define GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION 1
+
+void hci_add_event_handler(btstack_packet_callback_registration_t *callback_handler);
+int hci_power_control(int power_mode);
+
+void l2cap_init(void);
+void l2cap_add_event_handler(btstack_packet_callback_registration_t *callback_handler);
+void l2cap_set_max_le_mtu(uint16_t max_mtu);
+void sm_init(void);
+
+void gap_random_address_set(const bd_addr_t addr);
+void gap_advertisements_set_params(uint16_t adv_int_min, uint16_t adv_int_max, uint8_t adv_type,
+                                   uint8_t direct_address_typ, bd_addr_t direct_address,
+                                   uint8_t channel_map, uint8_t filter_policy);
+void gap_advertisements_set_data(uint8_t advertising_data_length, uint8_t *advertising_data);
+void gap_scan_response_set_data(uint8_t scan_response_data_length, uint8_t *scan_response_data);
+void gap_advertisements_enable(int enabled);
+int gap_request_connection_parameter_update(hci_con_handle_t con_handle, uint16_t conn_interval_min,
+                                            uint16_t conn_interval_max, uint16_t conn_latency,
+                                            uint16_t supervision_timeout);
+uint8_t gap_le_set_phy(hci_con_handle_t con_handle, uint8_t all_phys, uint8_t tx_phys, uint8_t rx_phys,
+                       uint8_t phy_options);
+uint8_t gap_le_set_data_length(hci_con_handle_t con_handle, uint16_t tx_octets, uint16_t tx_time);
+
+#include "btstack_event.h"
+
+#endif
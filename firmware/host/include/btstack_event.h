@@ -0,0 +1,109 @@
+#ifndef HOST_BTSTACK_EVENT_H
+#define HOST_BTSTACK_EVENT_H
+
+#include <stdint.h>
+#include "btstack_util.h"
+
+/* Event getters, with BTstack's field offsets. */
+
+static inline uint8_t hci_event_packet_get_type(const uint8_t *event) {
+    return event[0];
+}
+
+static inline uint8_t btstack_event_state_get_state(const uint8_t *event) {
+    return event[2];
+}
+
+static inline uint8_t hci_event_le_meta_get_subevent_code(const uint8_t *event) {
+    return event[2];
+}
+
+static inline uint8_t hci_subevent_le_connection_complete_get_status(const uint8_t *event) {
+    return event[3];
+}
+static inline uint16_t hci_subevent_le_connection_complete_get_connection_handle(const uint8_t *event) {
+    return little_endian_read_16(event, 4);
+}
+static inline uint16_t hci_subevent_le_connection_complete_get_conn_interval(const uint8_t *event) {
+    return little_endian_read_16(event, 14);
+}
+static inline uint16_t hci_subevent_le_connection_complete_get_conn_latency(const uint8_t *event) {
+    return little_endian_read_16(event, 16);
+}
+static inline uint16_t hci_subevent_le_connection_complete_get_supervision_timeout(const uint8_t *event) {
+    return little_endian_read_16(event, 18);
+}
+
+static inline uint8_t hci_subevent_le_connection_update_complete_get_status(const uint8_t *event) {
+    return event[3];
+}
+static inline uint16_t hci_subevent_le_connection_update_complete_get_connection_handle(const uint8_t *event) {
+    return little_endian_read_16(event, 4);
+}
+static inline uint16_t hci_subevent_le_connection_update_complete_get_conn_interval(const uint8_t *event) {
+    return little_endian_read_16(event, 6);
+}
+static inline uint16_t hci_subevent_le_connection_update_complete_get_conn_latency(const uint8_t *event) {
+    return little_endian_read_16(event, 8);
+}
+static inline uint16_t hci_subevent_le_connection_update_complete_get_supervision_timeout(const uint8_t *event) {
+    return little_endian_read_16(event, 10);
+}
+
+static inline uint16_t hci_subevent_le_data_length_change_get_connection_handle(const uint8_t *event) {
+    return little_endian_read_16(event, 3);
+}
+static inline uint16_t hci_subevent_le_data_length_change_get_max_tx_octets(const uint8_t *event) {
+    return little_endian_read_16(event, 5);
+}
+static inline uint16_t hci_subevent_le_data_length_change_get_max_tx_time(const uint8_t *event) {
+    return little_endian_read_16(event, 7);
+}
+static inline uint16_t hci_subevent_le_data_length_change_get_max_rx_octets(const uint8_t *event) {
+    return little_endian_read_16(event, 9);
+}
+static inline uint16_t hci_subevent_le_data_length_change_get_max_rx_time(const uint8_t *event) {
+    return little_endian_read_16(event, 11);
+}
+
+static inline uint8_t hci_subevent_le_phy_update_complete_get_status(const uint8_t *event) {
+    return event[3];
+}
+static inline uint16_t hci_subevent_le_phy_update_complete_get_connection_handle(const uint8_t *event) {
+    return little_endian_read_16(event, 4);
+}
+static inline uint8_t hci_subevent_le_phy_update_complete_get_tx_phy(const uint8_t *event) {
+    return event[6];
+}
+static inline uint8_t hci_subevent_le_phy_update_complete_get_rx_phy(const uint8_t *event) {
+    return event[7];
+}
+
+static inline uint16_t hci_event_disconnection_complete_get_connection_handle(const uint8_t *event) {
+    return little_endian_read_16(event, 3);
+}
+static inline uint8_t hci_event_disconnection_complete_get_reason(const uint8_t *event) {
+    return event[5];
+}
+
+static inline uint16_t att_event_connected_get_handle(const uint8_t *event) {
+    return little_endian_read_16(event, 9);
+}
+static inline uint16_t att_event_disconnected_get_handle(const uint8_t *event) {
+    return little_endian_read_16(event, 2);
+}
+static inline uint16_t att_event_mtu_exchange_complete_get_handle(const uint8_t *event) {
+    return little_endian_read_16(event, 2);
+}
+static inline uint16_t att_event_mtu_exchange_complete_get_MTU(const uint8_t *event) {
+    return little_endian_read_16(event, 4);
+}
+
+static inline uint16_t l2cap_event_connection_parameter_update_response_get_handle(const uint8_t *event) {
+    return little_endian_read_16(event, 2);
+}
+static inline uint16_t l2cap_event_connection_parameter_update_response_get_result(const uint8_t *event) {
+    return little_endian_read_16(event, 4);
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef HOST_BTSTACK_UTIL_H
+#define HOST_BTSTACK_UTIL_H
+
+#include <stdint.h>
+
+static inline uint16_t little_endian_read_16(const uint8_t *buffer, int position) {
+    return (uint16_t)(buffer[position] | (buffer[position + 1] << 8));
+}
+
+static inline uint32_t little_endian_read_32(const uint8_t *buffer, int position) {
+    return (uint32_t)buffer[position] | ((uint32_t)buffer[position + 1] << 8) |
+           ((uint32_t)buffer[position + 2] << 16) | ((uint32_t)buffer[position + 3] << 24);
+}
+
+static inline void little_endian_store_16(uint8_t *buffer, uint16_t position, uint16_t value) {
+    buffer[position] = (uint8_t)value;
+    buffer[position + 1] = (uint8_t)(value >> 8);
+}
+
+static inline void little_endian_store_32(uint8_t *buffer, uint16_t position, uint32_t value) {
+    buffer[position] = (uint8_t)value;
+    buffer[position + 1] = (uint8_t)(value >> 8);
+    buffer[position + 2] = (uint8_t)(value >> 16);
+    buffer[position + 3] = (uint8_t)(value >> 24);
+}
+
+#endif
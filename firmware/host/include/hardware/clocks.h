@@ -0,0 +1,13 @@
+#ifndef HOST_HARDWARE_CLOCKS_H
+#define HOST_HARDWARE_CLOCKS_H
+
+#include <stdint.h>
+
+enum clock_index {
+    clk_sys = 5
+};
+
+/* clk_sys is reported as the RP2040 default, 125 MHz. */
+uint32_t clock_get_hz(enum clock_index clk_index);
+
+#endif
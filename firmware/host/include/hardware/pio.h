@@ -0,0 +1,115 @@
+#ifndef HOST_HARDWARE_PIO_H
+#define HOST_HARDWARE_PIO_H
+
+#include "pico/stdlib.h"
+
+/*
+ * Host PIO: program memory, state machine claims and configuration are
+ * tracked, and every word written to a TX FIFO (directly or by DMA) goes
+ * to a per-state-machine recorder (see host_sim.h). Nothing runs live;
+ * host/emu/pio_emu.h replays recorded frames through the program.
+ */
+
+#define NUM_PIOS 2u
+#define NUM_PIO_STATE_MACHINES 4u
+#define PIO_INSTRUCTION_COUNT 32u
+
+typedef struct {
+    volatile uint32_t txf[NUM_PIO_STATE_MACHINES];
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+
+extern pio_hw_t pio0_hw_inst;
+extern pio_hw_t pio1_hw_inst;
+#define pio0 (&pio0_hw_inst)
+#define pio1 (&pio1_hw_inst)
+
+typedef struct pio_program {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+    uint8_t pio_version;
+} pio_program_t;
+
+enum pio_fifo_join {
+    PIO_FIFO_JOIN_NONE = 0,
+    PIO_FIFO_JOIN_TX = 1,
+    PIO_FIFO_JOIN_RX = 2
+};
+
+/* Decoded rather than packed into register images, so fakes can read it. */
+typedef struct {
+    float clkdiv;
+    uint wrap_target;
+    uint wrap;
+    uint sideset_bit_count;
+    bool sideset_optional;
+    uint sideset_base;
+    uint out_base;
+    uint out_count;
+    bool out_shift_right;
+    bool autopull;
+    uint pull_threshold;
+    enum pio_fifo_join fifo_join;
+} pio_sm_config;
+
+static inline pio_sm_config pio_get_default_sm_config(void) {
+    pio_sm_config c = {0};
+    c.clkdiv = 1.0f;
+    c.wrap = PIO_INSTRUCTION_COUNT - 1u;
+    c.out_shift_right = true;
+    c.pull_threshold = 32;
+    return c;
+}
+
+static inline void sm_config_set_wrap(pio_sm_config *c, uint wrap_target, uint wrap) {
+    c->wrap_target = wrap_target;
+    c->wrap = wrap;
+}
+
+static inline void sm_config_set_sideset(pio_sm_config *c, uint bit_count, bool optional, bool pindirs) {
+    (void)pindirs;
+    c->sideset_bit_count = bit_count;
+    c->sideset_optional = optional;
+}
+
+static inline void sm_config_set_sideset_pins(pio_sm_config *c, uint sideset_base) {
+    c->sideset_base = sideset_base;
+}
+
+static inline void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count) {
+    c->out_base = out_base;
+    c->out_count = out_count;
+}
+
+static inline void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, uint pull_threshold) {
+    c->out_shift_right = shift_right;
+    c->autopull = autopull;
+    c->pull_threshold = pull_threshold ? pull_threshold : 32u;
+}
+
+static inline void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join) {
+    c->fifo_join = join;
+}
+
+static inline void sm_config_set_clkdiv(pio_sm_config *c, float div) {
+    c->clkdiv = div;
+}
+
+uint pio_get_index(PIO pio);
+PIO pio_get_instance(uint instance);
+bool pio_can_add_program(PIO pio, const pio_program_t *program);
+uint pio_add_program(PIO pio, const pio_program_t *program);
+int pio_claim_unused_sm(PIO pio, bool required);
+void pio_sm_claim(PIO pio, uint sm);
+void pio_sm_unclaim(PIO pio, uint sm);
+bool pio_sm_is_claimed(PIO pio, uint sm);
+void pio_gpio_init(PIO pio, uint pin);
+int pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out);
+int pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx);
+
+#endif
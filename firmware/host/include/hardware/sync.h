@@ -0,0 +1,14 @@
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+#include "pico/stdlib.h"
+
+/*
+ * "Interrupts disabled" is one recursive lock shared by both cores and the
+ * simulated IRQ thread: coarser than the hardware, but it gives the same
+ * exclusion against handlers.
+ */
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t status);
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef HOST_SIM_H
+#define HOST_SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "btstack.h"
+#include "hardware/pio.h"
+
+/*
+ * Driver-side API of the host simulation. The firmware's main() is built
+ * as psl_firmware_main() and runs on a core0 thread; core1 and the
+ * simulated IRQs get threads of their own. Drivers play the BLE central
+ * through the host_ble_* calls (each runs in BTstack context, as the radio
+ * callbacks do on the target) and observe the strip via the PIO recorder.
+ */
+
+/* Boot the firmware and wait until it advertises. */
+void host_firmware_start(void);
+
+/* Sleep the driver thread; the firmware keeps running in real time. */
+void host_sleep_ms(uint32_t ms);
+
+/* Connect as a central; interval in 1.25 ms units. */
+hci_con_handle_t host_ble_connect(uint16_t interval);
+void host_ble_disconnect(void);
+/* Run the ATT MTU exchange; the result is capped at the server's maximum. */
+uint16_t host_ble_exchange_mtu(uint16_t client_mtu);
+/* Write without response. Returns the ATT error, or -1 if len exceeds MTU - 3. */
+int host_att_write(uint16_t attribute_handle, const uint8_t *data, uint16_t len);
+uint16_t host_att_read(uint16_t attribute_handle, uint16_t offset, uint8_t *buffer, uint16_t buffer_size);
+uint16_t host_ble_mtu(void);
+/* Connection interval currently in effect, 1.25 ms units. */
+uint16_t host_ble_interval(void);
+/* Notifications sent so far; copies the last one if value is non-NULL. */
+uint32_t host_ble_notifications(uint8_t *value, uint16_t max_len, uint16_t *len);
+bool host_ble_advertising(void);
+
+/*
+ * PIO recorder. Each DMA transfer into a TX FIFO is one frame, together with
+ * any transfers the completion IRQ restarts on the channel; words pushed
+ * directly with pio_sm_put_blocking() are appended to the frame in progress.
+ */
+#define HOST_PIO_MAX_FRAME_WORDS 4096u
+
+uint32_t host_pio_frame_count(PIO pio, uint sm);
+/* Copy the last complete frame; returns its length in words. */
+uint32_t host_pio_last_frame(PIO pio, uint sm, uint32_t *words, uint32_t max_words);
+/* Copy what the chain shows: frames only rewrite the prefix they were sent,
+ * so this is every frame so far, each laid over the ones before. */
+uint32_t host_pio_shown_frame(PIO pio, uint sm, uint32_t *words, uint32_t max_words);
+/* Wait until more than `count` frames have completed or timeout_ms passes. */
+bool host_pio_wait_frames(PIO pio, uint sm, uint32_t count, uint32_t timeout_ms);
+/* Claimed state machine configuration and program, for inspection. */
+bool host_pio_sm_config(PIO pio, uint sm, pio_sm_config *config, uint *initial_pc);
+const uint16_t *host_pio_instructions(PIO pio);
+/* Configured state machines, pio0 first: the order the output engine claims
+ * them for its strips. Returns how many were stored. */
+uint host_pio_configured_sms(PIO *pios, uint *sms, uint max);
+
+bool host_reboot_requested(void);
+
+/* Fakes' internals shared between fake_*.c. */
+void host_set_core(uint core);
+/* Run fn(arg) on the simulated IRQ thread, as `core`, at time_us_64() >= at_us. */
+void host_schedule_at(uint64_t at_us, uint core, void (*fn)(void *arg), void *arg);
+/* Call the handlers of an enabled IRQ; only from a scheduled callback. */
+void host_irq_dispatch(uint num);
+void host_pio_record_words(PIO pio, uint sm, const uint32_t *words, uint32_t count, bool end_frame);
+uint64_t host_pio_word_time_ns(PIO pio, uint sm);
+void host_btstack_lock(void);
+void host_btstack_unlock(void);
+
+#endif
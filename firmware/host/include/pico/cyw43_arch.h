@@ -0,0 +1,7 @@
+#ifndef HOST_PICO_CYW43_ARCH_H
+#define HOST_PICO_CYW43_ARCH_H
+
+int cyw43_arch_init(void);
+void cyw43_arch_deinit(void);
+
+#endif
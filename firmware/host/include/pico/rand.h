@@ -0,0 +1,9 @@
+#ifndef HOST_PICO_RAND_H
+#define HOST_PICO_RAND_H
+
+#include <stdint.h>
+
+/* Deterministic on the host, so simulation runs are repeatable. */
+uint32_t get_rand_32(void);
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Host stand-in for the parts of pico/stdlib.h the firmware uses. Time is
+ * the host's monotonic clock in microseconds since start-up; alarms and
+ * interrupts run on a simulated IRQ thread (fakes/fake_pico.c).
+ */
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+#define PICO_STDIO_USB 1
+/* As boards/pico_w.h: the radio takes GPIO 23, 24, 25 and 29. */
+#define PICO_CYW43_SUPPORTED 1
+#define PICO_ERROR_TIMEOUT (-1)
+#define at_the_end_of_time ((absolute_time_t)UINT64_MAX)
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+#define __not_in_flash_func(f) f
+#define __time_critical_func(f) f
+
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+
+static inline absolute_time_t get_absolute_time(void) {
+    return time_us_64();
+}
+
+static inline absolute_time_t make_timeout_time_us(uint64_t us) {
+    return time_us_64() + us;
+}
+
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) {
+    return time_us_64() + (uint64_t)ms * 1000u;
+}
+
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return (int64_t)(to - from);
+}
+
+static inline bool is_at_the_end_of_time(absolute_time_t t) {
+    return t == at_the_end_of_time;
+}
+
+static inline bool time_reached(absolute_time_t t) {
+    return time_us_64() >= t;
+}
+
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+void tight_loop_contents(void);
+
+bool stdio_init_all(void);
+int getchar_timeout_us(uint32_t timeout_us);
+
+uint get_core_num(void);
+
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+typedef struct alarm_pool alarm_pool_t;
+
+alarm_pool_t *alarm_pool_create_with_unused_hardware_alarm(uint max_timers);
+alarm_id_t alarm_pool_add_alarm_in_us(alarm_pool_t *pool, uint64_t us, alarm_callback_t callback,
+                                      void *user_data, bool fire_if_past);
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+
+#endif
@@ -0,0 +1,417 @@
+/*
+ * End-to-end run of the firmware on the host: boot, connect as a central,
+ * drive it with the packets the iOS app sends and check what reaches the
+ * PIO. Exits non-zero if a step does not produce the expected strip output.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host_sim.h"
+#include "frame_protocol.h"
+#include "frame_reassembly.h"
+#include "latency_trace.h"
+#include "motion_protocol.h"
+#include "pio_emu.h"
+#include "psl_motion_gatt.h"
+#include "renderer.h"
+#include "strip_config.h"
+#include "telemetry.h"
+#include "ws2812_output.h"
+#include "ws2812_wire.h"
+#include "hardware/clocks.h"
+
+#define SIM_LED_COUNT 300u
+#define SIM_CLIENT_MTU 247u
+#define SIM_INTERVAL_30MS 24u
+#define SIM_FRAME_TIMEOUT_MS 500u
+#define SIM_BURST_WRITES 200u
+#define SIM_WHITE 0xffffff00u
+/* Lit pixels of the 0xA5 upload: alternating, or in blocks of 8 where the
+ * strip is kept as a run list (RUN_LIST_MAX_RUNS runs). */
+#if PSL_RUN_LIST_OUTPUT
+#define SIM_PIXEL_LIT(i) (((i) >> 3) & 1u)
+#else
+#define SIM_PIXEL_LIT(i) ((i) & 1u)
+#endif
+
+static const uint16_t command_handle = ATT_CHARACTERISTIC_0C1D2E3F_4051_6273_8495_A6B7C8D9EAFB_01_VALUE_HANDLE;
+static const uint16_t telemetry_config_handle =
+    ATT_CHARACTERISTIC_0C1D2E3F_4051_6273_8495_A6B7C8D9EAFC_01_CLIENT_CONFIGURATION_HANDLE;
+
+static uint32_t frame_words[HOST_PIO_MAX_FRAME_WORDS];
+static uint32_t wire_pixels[HOST_PIO_MAX_FRAME_WORDS];
+static pio_emu_edge_t wire_edges[HOST_PIO_MAX_FRAME_WORDS * 48u + 2u];
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+    printf("sim: %-44s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) {
+        failures++;
+    }
+}
+
+static int write_text(const char *text) {
+    return host_att_write(command_handle, (const uint8_t *)text, (uint16_t)strlen(text));
+}
+
+/* The firmware's output chains, in strip order. */
+static PIO strip_pios[WS2812_MAX_STRIPS];
+static uint strip_sms[WS2812_MAX_STRIPS];
+static uint32_t strip_lens[WS2812_MAX_STRIPS];
+static uint strip_count;
+
+/* The last frame a chain was sent, which is all the wire carried. */
+static uint32_t wire_words[HOST_PIO_MAX_FRAME_WORDS];
+
+#if PSL_PARALLEL_OUTPUT
+#define SIM_WORDS_PER_PIXEL 24u
+
+/* The bit planes the strip shows, one word per bit time. */
+static uint32_t plane_words[HOST_PIO_MAX_FRAME_WORDS];
+static pio_sm_config plane_config;
+static uint plane_initial_pc;
+
+/* Lane `lane`'s GRB word in row `row` of a frame of bit planes. */
+static uint32_t lane_word(const uint32_t *planes, uint32_t row, uint lane) {
+    uint32_t word = 0;
+    for (uint bit = 0; bit < 24u; ++bit) {
+        word |= ((planes[row * 24u + bit] >> lane) & 1u) << (31u - bit);
+    }
+    return word;
+}
+
+/* Wait for the strip to show a frame written after `before`, then rebuild
+ * every lane's GRB words from the bit planes, lanes in strip order. */
+static uint32_t next_frame(uint32_t before) {
+    if (!host_pio_wait_frames(pio0, 0, before, SIM_FRAME_TIMEOUT_MS)) {
+        return 0;
+    }
+    host_sleep_ms(40);
+    if (host_pio_configured_sms(strip_pios, strip_sms, 1) != 1 ||
+        !host_pio_sm_config(strip_pios[0], strip_sms[0], &plane_config, &plane_initial_pc)) {
+        return 0;
+    }
+    uint32_t plane_len = host_pio_shown_frame(strip_pios[0], strip_sms[0], plane_words, HOST_PIO_MAX_FRAME_WORDS);
+    /* Lanes split the strip the way the renderer does. */
+    strip_count = plane_config.out_count;
+    uint32_t len = 0;
+    for (uint lane = 0; lane < strip_count; ++lane) {
+        strip_lens[lane] = (lane + 1u) * SIM_LED_COUNT / strip_count - lane * SIM_LED_COUNT / strip_count;
+        if (strip_lens[lane] * 24u > plane_len) {
+            return 0;
+        }
+        for (uint32_t row = 0; row < strip_lens[lane]; ++row) {
+            frame_words[len++] = lane_word(plane_words, row, lane);
+        }
+    }
+    return len;
+}
+
+/* Run the last bit planes through the emulated PIO program once and decode
+ * the pulses on every lane's pin. */
+static bool wire_matches_words(void) {
+    uint32_t len = host_pio_last_frame(strip_pios[0], strip_sms[0], wire_words, HOST_PIO_MAX_FRAME_WORDS);
+    pio_emu_result_t run = pio_emu_run(host_pio_instructions(strip_pios[0]), &plane_config, plane_initial_pc, 0,
+                                       wire_words, len, wire_edges, sizeof(wire_edges) / sizeof(wire_edges[0]));
+    if (run.status != PIO_EMU_OK) {
+        return false;
+    }
+    const double cycle_ns = pio_emu_cycle_ns(&plane_config, clock_get_hz(clk_sys));
+    for (uint lane = 0; lane < strip_count; ++lane) {
+        ws2812_wire_report_t report;
+        ws2812_wire_decode(wire_edges, &run, cycle_ns, plane_config.out_base + lane, &ws2812_wire_spec_ws2812b,
+                           wire_pixels, HOST_PIO_MAX_FRAME_WORDS, &report);
+        if (report.pixels != len / 24u ||
+            report.t0h_violations + report.t1h_violations + report.bit_violations + report.early_latches) {
+            return false;
+        }
+        for (uint32_t row = 0; row < report.pixels; ++row) {
+            if (wire_pixels[row] != lane_word(wire_words, row, lane) >> 8) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+#else
+#define SIM_WORDS_PER_PIXEL 1u
+
+/* Wait for the strip to show a frame written after `before`, then fetch
+ * what every chain shows. */
+static uint32_t next_frame(uint32_t before) {
+    if (!host_pio_wait_frames(pio0, 0, before, SIM_FRAME_TIMEOUT_MS)) {
+        return 0;
+    }
+    /* Let a frame that was already in flight be followed by ours. */
+    host_sleep_ms(40);
+    strip_count = host_pio_configured_sms(strip_pios, strip_sms, WS2812_MAX_STRIPS);
+    uint32_t len = 0;
+    for (uint i = 0; i < strip_count; ++i) {
+        strip_lens[i] = host_pio_shown_frame(strip_pios[i], strip_sms[i], frame_words + len,
+                                             HOST_PIO_MAX_FRAME_WORDS - len);
+        len += strip_lens[i];
+    }
+    return len;
+}
+
+/* Run each chain's last frame through the emulated PIO program and decode
+ * the pulses. */
+static bool wire_matches_words(void) {
+    for (uint s = 0; s < strip_count; ++s) {
+        pio_sm_config config;
+        uint initial_pc;
+        if (!host_pio_sm_config(strip_pios[s], strip_sms[s], &config, &initial_pc)) {
+            return false;
+        }
+        const uint32_t len = host_pio_last_frame(strip_pios[s], strip_sms[s], wire_words, HOST_PIO_MAX_FRAME_WORDS);
+        pio_emu_result_t run = pio_emu_run(host_pio_instructions(strip_pios[s]), &config, initial_pc, 0,
+                                           wire_words, len, wire_edges, sizeof(wire_edges) / sizeof(wire_edges[0]));
+        if (run.status != PIO_EMU_OK) {
+            return false;
+        }
+        ws2812_wire_report_t report;
+        ws2812_wire_decode(wire_edges, &run, pio_emu_cycle_ns(&config, clock_get_hz(clk_sys)),
+                           config.sideset_base, &ws2812_wire_spec_ws2812b, wire_pixels, HOST_PIO_MAX_FRAME_WORDS,
+                           &report);
+        if (report.pixels != len ||
+            report.t0h_violations + report.t1h_violations + report.bit_violations + report.early_latches) {
+            return false;
+        }
+        for (uint32_t i = 0; i < len; ++i) {
+            if (wire_pixels[i] != wire_words[i] >> 8) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+#endif
+
+static void run_text_commands(void) {
+    uint32_t before = host_pio_frame_count(pio0, 0);
+    check(write_text("H_SET,120") == 0 && write_text("B_SET,100") == 0, "text commands accepted");
+    uint32_t len = next_frame(before);
+    check(len == SIM_LED_COUNT, "text command refreshes the whole strip");
+    check(len && frame_words[0] != 0, "hue 120 at full brightness is lit");
+}
+
+static void run_frame_runs(void) {
+    /* Black strip with LEDs 10..19 white. */
+    const uint8_t frame[] = {
+        PSL_FRAME_COMMAND_ID, PSL_FRAME_VERSION, 2,
+        0, 0, SIM_LED_COUNT & 0xff, SIM_LED_COUNT >> 8, 0, 0, 0,
+        10, 0, 10, 0, 255, 255, 255,
+    };
+    uint32_t before = host_pio_frame_count(pio0, 0);
+    check(host_att_write(command_handle, frame, sizeof(frame)) == 0, "0xA0 run frame accepted");
+    uint32_t len = next_frame(before);
+    bool ok = len == SIM_LED_COUNT;
+    for (uint32_t i = 0; ok && i < len; ++i) {
+        ok = frame_words[i] == ((i >= 10 && i < 20) ? SIM_WHITE : 0u);
+    }
+    check(ok, "0xA0 runs reach the PIO as GRB words");
+    check(len && wire_matches_words(), "PIO pulse train decodes to the same words");
+}
+
+/* Follows run_frame_runs(): only LEDs 0..1 change, so only they are sent. */
+static void run_prefix_refresh(void) {
+    const uint8_t frame[] = {
+        PSL_FRAME_COMMAND_ID, PSL_FRAME_VERSION, 3,
+        0, 0, SIM_LED_COUNT & 0xff, SIM_LED_COUNT >> 8, 0, 0, 0,
+        0, 0, 2, 0, 255, 255, 255,
+        10, 0, 10, 0, 255, 255, 255,
+    };
+    uint32_t before = host_pio_frame_count(pio0, 0);
+    check(host_att_write(command_handle, frame, sizeof(frame)) == 0, "0xA0 prefix frame accepted");
+    uint32_t len = next_frame(before);
+    bool ok = len == SIM_LED_COUNT;
+    for (uint32_t i = 0; ok && i < len; ++i) {
+        ok = frame_words[i] == ((i < 2 || (i >= 10 && i < 20)) ? SIM_WHITE : 0u);
+    }
+    check(ok, "LEDs past the prefix keep their colour");
+    check(host_pio_last_frame(strip_pios[0], strip_sms[0], wire_words, HOST_PIO_MAX_FRAME_WORDS) ==
+              2u * SIM_WORDS_PER_PIXEL,
+          "only the changed prefix is clocked out");
+    check(len && wire_matches_words(), "prefix refresh decodes to the same words");
+
+#if !PSL_ENABLE_DITHER
+    /* Dithering refreshes continuously, whatever was written. */
+    uint32_t unchanged = ws2812_output_frames_unchanged();
+    before = host_pio_frame_count(pio0, 0);
+    check(host_att_write(command_handle, frame, sizeof(frame)) == 0, "identical 0xA0 frame accepted");
+    host_sleep_ms(40);
+    check(ws2812_output_frames_unchanged() == unchanged + 1u && host_pio_frame_count(pio0, 0) == before,
+          "an unchanged frame is not sent");
+#endif
+}
+
+/* An 0xA5 frame in fragments of `chunk` payload bytes, `pace_ms` apart;
+ * `lit` picks whether the SIM_PIXEL_LIT pixels or the others are white. */
+static void run_fragmented_pixels(size_t chunk, uint32_t pace_ms, bool lit, const char *what) {
+    static uint8_t packet[PSL_FRAME_PIXELS_HEADER_LEN + SIM_LED_COUNT * 3u];
+    packet[0] = PSL_FRAME_PIXELS_COMMAND_ID;
+    packet[1] = PSL_FRAME_VERSION;
+    packet[2] = 0;
+    packet[3] = 0;
+    packet[4] = SIM_LED_COUNT & 0xff;
+    packet[5] = SIM_LED_COUNT >> 8;
+    for (uint32_t i = 0; i < SIM_LED_COUNT; ++i) {
+        memset(&packet[PSL_FRAME_PIXELS_HEADER_LEN + i * 3u], !SIM_PIXEL_LIT(i) == !lit ? 255 : 0, 3);
+    }
+
+    const uint8_t count = (uint8_t)((sizeof(packet) + chunk - 1u) / chunk);
+    uint32_t before = host_pio_frame_count(pio0, 0);
+    bool written = true;
+    for (uint8_t index = 0; index < count; ++index) {
+        uint8_t fragment[SIM_CLIENT_MTU];
+        size_t offset = (size_t)index * chunk;
+        size_t len = sizeof(packet) - offset < chunk ? sizeof(packet) - offset : chunk;
+        fragment[0] = PSL_FRAGMENT_COMMAND_ID;
+        fragment[1] = 7;
+        fragment[2] = index;
+        fragment[3] = count;
+        fragment[4] = index + 1u == count ? PSL_FRAGMENT_FLAG_FINAL : 0;
+        memcpy(&fragment[PSL_FRAGMENT_HEADER_LEN], &packet[offset], len);
+        written = written && host_att_write(command_handle, fragment, (uint16_t)(PSL_FRAGMENT_HEADER_LEN + len)) == 0;
+        if (pace_ms) {
+            host_sleep_ms(pace_ms);
+        }
+    }
+    check(written, "0xA4 fragments accepted");
+    uint32_t len = next_frame(before);
+    bool ok = len == SIM_LED_COUNT;
+    for (uint32_t i = 0; ok && i < len; ++i) {
+        ok = frame_words[i] == (!SIM_PIXEL_LIT(i) == !lit ? SIM_WHITE : 0u);
+    }
+    check(ok, what);
+}
+
+static void run_burst(void) {
+    render_stats_t stats_before;
+    render_stats_t stats_after;
+    renderer_get_stats(&stats_before);
+    uint32_t before = host_pio_frame_count(pio0, 0);
+    for (uint32_t i = 0; i < SIM_BURST_WRITES; ++i) {
+        write_text("H,5");
+    }
+    next_frame(before);
+    host_sleep_ms(100);
+    renderer_get_stats(&stats_after);
+    uint32_t requested = stats_after.requested - stats_before.requested;
+    uint32_t rendered = stats_after.rendered - stats_before.rendered;
+    printf("sim: burst of %u writes: %lu requested, %lu rendered, %lu strip refreshes\n",
+           SIM_BURST_WRITES, (unsigned long)requested, (unsigned long)rendered,
+           (unsigned long)(host_pio_frame_count(pio0, 0) - before));
+    check(requested == SIM_BURST_WRITES && rendered < requested, "write bursts coalesce into fewer renders");
+}
+
+/* A frame committed in the same render tick as state commands replaces
+ * them, rather than being painted over by the hue/segment state. */
+static void run_state_then_frame(void) {
+    const uint8_t frame[] = {
+        PSL_FRAME_COMMAND_ID, PSL_FRAME_VERSION, 2,
+        0, 0, SIM_LED_COUNT & 0xff, SIM_LED_COUNT >> 8, 0, 0, 0,
+        10, 0, 10, 0, 255, 255, 255,
+    };
+    uint32_t before = host_pio_frame_count(pio0, 0);
+    check(write_text("H,5") == 0 && write_text("H_SET,120") == 0 &&
+              host_att_write(command_handle, frame, sizeof(frame)) == 0,
+          "state commands then 0xA0 frame accepted");
+    host_sleep_ms(40);
+    uint32_t len = next_frame(before);
+    bool ok = len == SIM_LED_COUNT;
+    for (uint32_t i = 0; ok && i < len; ++i) {
+        ok = frame_words[i] == ((i >= 10 && i < 20) ? SIM_WHITE : 0u);
+    }
+    check(ok, "the frame wins over pending state");
+}
+
+static void run_telemetry(void) {
+    const uint8_t enable[2] = {GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION, 0};
+    check(host_att_write(telemetry_config_handle, enable, sizeof(enable)) == 0, "telemetry notifications enabled");
+    host_sleep_ms(TELEMETRY_PERIOD_MS + 200u);
+    uint8_t sample[TELEMETRY_SAMPLE_LEN];
+    uint16_t len = 0;
+    uint32_t count = host_ble_notifications(sample, sizeof(sample), &len);
+    check(count > 0 && len == TELEMETRY_SAMPLE_LEN && sample[0] == TELEMETRY_VERSION,
+          "telemetry sample notified");
+}
+
+static int write_motion(uint16_t seq, int16_t yaw) {
+    const uint8_t packet[] = {
+        PSL_MOTION_COMMAND_ID, PSL_MOTION_FLAG_SEQ, 0, 0, 0, 0,
+        (uint8_t)yaw, (uint8_t)((uint16_t)yaw >> 8), (uint8_t)seq, (uint8_t)(seq >> 8),
+    };
+    return host_att_write(command_handle, packet, sizeof(packet));
+}
+
+/* A client that reconnects starts its sequence numbers over. */
+static void run_motion_reconnect(void) {
+    uint32_t before = host_pio_frame_count(pio0, 0);
+    check(write_motion(1000, -8192) == 0 && next_frame(before), "sequenced 0xA2 motion shown");
+    const uint32_t first = frame_words[0];
+
+    host_ble_disconnect();
+    host_sleep_ms(10);
+    host_ble_connect(SIM_INTERVAL_30MS);
+    host_ble_exchange_mtu(SIM_CLIENT_MTU);
+    before = host_pio_frame_count(pio0, 0);
+    check(write_motion(0, 8192) == 0 && next_frame(before) && frame_words[0] != first,
+          "seq 0 after reconnect is not stale");
+}
+
+/* Last: a good CFG halts the renderer and "reboots", which the host only records. */
+static void run_strip_config(void) {
+    strip_config_t config;
+    check(write_text("CFG,XYZ,2:100") == 0 && write_text("CFG,RGB,2:100,2:120") == 0 &&
+              !strip_config_load(&config) && !host_reboot_requested(),
+          "bad CFG leaves flash and the strip alone");
+    check(write_text("CFG,RGB,24:100") == 0 && !strip_config_load(&config) && !host_reboot_requested(),
+          "CFG on a radio pin is rejected");
+#if !PSL_PARALLEL_OUTPUT
+    /* The CYW43 driver holds a state machine on a Pico W. */
+    pio_sm_claim(pio1, 3);
+    check(write_text("CFG,RGB,0:10,1:10,2:10,3:10,4:10,5:10,6:10,7:10") == 0 && !strip_config_load(&config) &&
+              !host_reboot_requested(),
+          "CFG with more chains than free state machines is rejected");
+    pio_sm_unclaim(pio1, 3);
+#endif
+    check(write_text("CFG,RGB,2:100,3:120") == 0 && host_reboot_requested(), "CFG reboots into the new geometry");
+    check(strip_config_load(&config) && config.led_count == 220u && config.chain_count == 2u &&
+              config.pins[1] == 3u && config.chain_leds[1] == 120u && config.color_order == PIXEL_ORDER_RGB,
+          "CFG is stored in flash");
+}
+
+int main(void) {
+    host_firmware_start();
+    host_ble_connect(SIM_INTERVAL_30MS);
+    uint16_t mtu = host_ble_exchange_mtu(SIM_CLIENT_MTU);
+    check(mtu == SIM_CLIENT_MTU, "MTU exchange");
+
+    run_text_commands();
+    host_sleep_ms(50);
+    check(host_ble_interval() < SIM_INTERVAL_30MS, "streaming requests a faster interval");
+    run_frame_runs();
+    run_prefix_refresh();
+    run_fragmented_pixels(host_ble_mtu() - 3u - PSL_FRAGMENT_HEADER_LEN, 0, true,
+                          "reassembled 0xA5 pixels reach the PIO");
+    /* A default 23-byte MTU: ~60 fragments, longer in all than the timeout. */
+    run_fragmented_pixels(23u - 3u - PSL_FRAGMENT_HEADER_LEN, 10u, false,
+                          "slow fragments reassemble past the timeout");
+    run_burst();
+    run_state_then_frame();
+    run_telemetry();
+    run_motion_reconnect();
+    run_strip_config();
+
+    latency_trace_dump();
+    host_ble_disconnect();
+    host_sleep_ms(10);
+    check(host_ble_advertising(), "advertising resumes after disconnect");
+
+    printf("sim: %lu strip refreshes on %u chain(s), %s\n", (unsigned long)host_pio_frame_count(pio0, 0), strip_count,
+           failures ? "FAILED" : "all checks passed");
+    (void)profile_data;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,289 @@
+/*
+ * WS2812 wire analysis. Boots the firmware, sends it a frame of pseudo-random
+ * pixels, runs the words each of its chains pushed through the PIO emulator
+ * with the program and configuration it loaded, decodes the pulse train and checks it against
+ * the pushed words and the WS2812B timing windows; a PSL_PARALLEL_OUTPUT
+ * build is decoded lane by lane from its one state machine. Then tabulates wire time
+ * and the highest frame rate for each LED count, split into parallel chains,
+ * and T1/T2/T3 set:
+ *
+ *   psl_wire [--leds <n>]... [--chains <n>]... [--timing <t1>,<t2>,<t3>[@<bit_hz>]]...
+ *            [--reset-us <us>]
+ *
+ * Exits non-zero if the firmware's frame does not survive the round trip.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_sim.h"
+#include "frame_protocol.h"
+#include "frame_reassembly.h"
+#include "psl_motion_gatt.h"
+#include "pio_emu.h"
+#include "ws2812_output.h"
+#include "ws2812_wire.h"
+#include "hardware/clocks.h"
+
+#define WIRE_MAX_LEDS 2048u
+#define WIRE_MAX_EDGES (WIRE_MAX_LEDS * 24u * 2u + 2u)
+#define WIRE_MAX_ARGS 8u
+#define WIRE_FIRMWARE_LEDS 300u
+#define WIRE_FRAME_TIMEOUT_MS 500u
+#define WIRE_DEFAULT_RESET_US 280u
+#define WIRE_PIN 0u
+
+static const uint16_t command_handle = ATT_CHARACTERISTIC_0C1D2E3F_4051_6273_8495_A6B7C8D9EAFB_01_VALUE_HANDLE;
+
+static pio_emu_edge_t edges[WIRE_MAX_EDGES];
+static uint32_t words[WIRE_MAX_LEDS];
+static uint32_t decoded[WIRE_MAX_LEDS];
+static uint8_t packet[PSL_FRAME_PIXELS_HEADER_LEN + WIRE_FIRMWARE_LEDS * 3u];
+
+static uint32_t rng_state = 0x2545f491u;
+
+static uint32_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static uint32_t count_mismatches(const uint32_t *pushed, uint32_t count, const ws2812_wire_report_t *report) {
+    uint32_t mismatches = count > report->pixels ? count - report->pixels : report->pixels - count;
+    uint32_t common = count < report->pixels ? count : report->pixels;
+    for (uint32_t i = 0; i < common; ++i) {
+        mismatches += decoded[i] != pushed[i] >> 8;
+    }
+    return mismatches;
+}
+
+static uint32_t violations(const ws2812_wire_report_t *report) {
+    return report->t0h_violations + report->t1h_violations + report->bit_violations + report->early_latches;
+}
+
+static double max_fps(const ws2812_wire_report_t *report, uint32_t reset_us) {
+    return 1e9 / (report->wire_ns + (double)reset_us * 1000.0);
+}
+
+/* Send the frame in 0xA4 fragments, as the app does. */
+static bool send_pixels(void) {
+    packet[0] = PSL_FRAME_PIXELS_COMMAND_ID;
+    packet[1] = PSL_FRAME_VERSION;
+    packet[2] = 0;
+    packet[3] = 0;
+    packet[4] = WIRE_FIRMWARE_LEDS & 0xff;
+    packet[5] = WIRE_FIRMWARE_LEDS >> 8;
+    for (uint32_t i = PSL_FRAME_PIXELS_HEADER_LEN; i < sizeof(packet); ++i) {
+        packet[i] = (uint8_t)next_random();
+    }
+    const size_t chunk = host_ble_mtu() - 3u - PSL_FRAGMENT_HEADER_LEN;
+    const uint8_t count = (uint8_t)((sizeof(packet) + chunk - 1u) / chunk);
+    for (uint8_t index = 0; index < count; ++index) {
+        uint8_t fragment[256];
+        size_t offset = (size_t)index * chunk;
+        size_t len = sizeof(packet) - offset < chunk ? sizeof(packet) - offset : chunk;
+        fragment[0] = PSL_FRAGMENT_COMMAND_ID;
+        fragment[1] = 1;
+        fragment[2] = index;
+        fragment[3] = count;
+        fragment[4] = index + 1u == count ? PSL_FRAGMENT_FLAG_FINAL : 0;
+        memcpy(&fragment[PSL_FRAGMENT_HEADER_LEN], &packet[offset], len);
+        if (host_att_write(command_handle, fragment, (uint16_t)(PSL_FRAGMENT_HEADER_LEN + len)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Lane `lane`'s GRB words out of a ws2812_parallel frame of bit planes. */
+static uint32_t lane_words(const uint32_t *planes, uint32_t count, uint lane, uint32_t *out) {
+    uint32_t rows = count / 24u;
+    for (uint32_t row = 0; row < rows; ++row) {
+        uint32_t word = 0;
+        for (uint bit = 0; bit < 24u; ++bit) {
+            word |= ((planes[row * 24u + bit] >> lane) & 1u) << (31u - bit);
+        }
+        out[row] = word;
+    }
+    return rows;
+}
+
+/*
+ * Emulate and decode one state machine's frame; returns its mismatching
+ * pixels. A program without side-set is ws2812_parallel: every out pin is a
+ * lane, decoded against its bits of the planes, and report sums the lanes.
+ */
+static uint32_t analyse_chain(PIO pio, uint sm, uint32_t reset_us, ws2812_wire_report_t *report) {
+    static uint32_t expected[WIRE_MAX_LEDS];
+    uint32_t count = host_pio_last_frame(pio, sm, words, WIRE_MAX_LEDS);
+    pio_sm_config config;
+    uint initial_pc;
+    host_pio_sm_config(pio, sm, &config, &initial_pc);
+    double cycle_ns = pio_emu_cycle_ns(&config, clock_get_hz(clk_sys));
+    pio_emu_result_t run =
+        pio_emu_run(host_pio_instructions(pio), &config, initial_pc, 0, words, count, edges, WIRE_MAX_EDGES);
+    memset(report, 0, sizeof(*report));
+    if (run.status != PIO_EMU_OK) {
+        printf("firmware: emulation stopped (status %d, instruction 0x%04x)\n", run.status, run.bad_instruction);
+        return count ? count : 1u;
+    }
+    const bool parallel = config.sideset_bit_count == 0u;
+    const uint lanes = parallel ? config.out_count : 1u;
+    uint32_t mismatches = 0;
+    for (uint lane = 0; lane < lanes; ++lane) {
+        const uint pin = parallel ? config.out_base + lane : config.sideset_base;
+        const uint32_t *pushed = words;
+        uint32_t pixels = count;
+        if (parallel) {
+            pixels = lane_words(words, count, lane, expected);
+            pushed = expected;
+        }
+        ws2812_wire_report_t lane_report;
+        ws2812_wire_decode(edges, &run, cycle_ns, pin, &ws2812_wire_spec_ws2812b, decoded, WIRE_MAX_LEDS,
+                           &lane_report);
+        mismatches += count_mismatches(pushed, pixels, &lane_report);
+        printf("firmware: pio%u sm%u pin %u: %lu pixels, SM clock %.3f MHz (clkdiv %.4f), T0H %.0f ns, "
+               "T1H %.0f ns, bit %.0f ns, wire %.1f us + latch %lu us\n",
+               pio_get_index(pio), sm, pin, (unsigned long)pixels, 1e3 / cycle_ns, (double)config.clkdiv,
+               lane_report.t0h_ns, lane_report.t1h_ns, lane_report.bit_ns, lane_report.wire_ns / 1000.0,
+               (unsigned long)reset_us);
+        lane_report.pixels += report->pixels;
+        lane_report.t0h_violations += report->t0h_violations;
+        lane_report.t1h_violations += report->t1h_violations;
+        lane_report.bit_violations += report->bit_violations;
+        lane_report.early_latches += report->early_latches;
+        *report = lane_report;
+    }
+    return mismatches;
+}
+
+static bool analyse_firmware(uint32_t reset_us) {
+    host_firmware_start();
+    host_ble_connect(24);
+    host_ble_exchange_mtu(247);
+    uint32_t before = host_pio_frame_count(pio0, 0);
+    if (!send_pixels() || !host_pio_wait_frames(pio0, 0, before, WIRE_FRAME_TIMEOUT_MS)) {
+        printf("firmware: no frame reached the PIO\n");
+        return false;
+    }
+    host_sleep_ms(40);
+
+    PIO pios[WIRE_MAX_ARGS];
+    uint sms[WIRE_MAX_ARGS];
+    uint chains = host_pio_configured_sms(pios, sms, WIRE_MAX_ARGS);
+    uint32_t pixels = 0;
+    uint32_t mismatches = 0;
+    uint32_t violation_count = 0;
+    ws2812_wire_report_t longest = {0};
+    for (uint c = 0; c < chains; ++c) {
+        ws2812_wire_report_t report;
+        mismatches += analyse_chain(pios[c], sms[c], reset_us, &report);
+        pixels += report.pixels;
+        violation_count += violations(&report);
+        if (report.wire_ns > longest.wire_ns) {
+            longest = report;
+        }
+    }
+    printf("firmware: %u chain(s), %lu timing violations (%s), %.1f fps max\n", chains,
+           (unsigned long)violation_count, ws2812_wire_spec_ws2812b.name, max_fps(&longest, reset_us));
+    printf("firmware: decoded %lu pixels, %lu differ from the pushed words\n", (unsigned long)pixels,
+           (unsigned long)mismatches);
+    host_ble_disconnect();
+    return chains > 0 && mismatches == 0 && violation_count == 0;
+}
+
+/* Chains are clocked out together, so only the longest one is emulated. */
+static void analyse_timing(const ws2812_wire_timing_t *timing, uint32_t total_leds, uint32_t chains,
+                           uint32_t reset_us) {
+    static uint16_t instructions[PIO_INSTRUCTION_COUNT];
+    pio_sm_config config;
+    ws2812_wire_program(timing, WIRE_PIN, clock_get_hz(clk_sys), instructions, &config);
+    const uint32_t leds = (total_leds + chains - 1u) / chains;
+    for (uint32_t i = 0; i < leds; ++i) {
+        words[i] = next_random() << 8;
+    }
+    pio_emu_result_t run = pio_emu_run(instructions, &config, 0, 0, words, leds, edges, WIRE_MAX_EDGES);
+    double cycle_ns = pio_emu_cycle_ns(&config, clock_get_hz(clk_sys));
+    ws2812_wire_report_t report;
+    ws2812_wire_decode(edges, &run, cycle_ns, WIRE_PIN, &ws2812_wire_spec_ws2812b, decoded, WIRE_MAX_LEDS,
+                       &report);
+    bool ok = run.status == PIO_EMU_OK && count_mismatches(words, leds, &report) == 0;
+    printf("%5lu  %6lu  %2u/%2u/%2u  %7.0f  %6.0f  %6.0f  %6.0f  %9.1f  %7.1f  %10lu  %s\n", (unsigned long)total_leds,
+           (unsigned long)chains, timing->t1, timing->t2, timing->t3, (double)timing->bit_hz / 1000.0, report.t0h_ns, report.t1h_ns,
+           report.bit_ns, report.wire_ns / 1000.0, max_fps(&report, reset_us), (unsigned long)violations(&report),
+           ok ? "decodes" : "CORRUPT");
+}
+
+static bool parse_timing(const char *text, ws2812_wire_timing_t *timing) {
+    timing->bit_hz = 800000.0f;
+    int matched = sscanf(text, "%u,%u,%u@%f", &timing->t1, &timing->t2, &timing->t3, &timing->bit_hz);
+    return matched >= 3 && ws2812_wire_timing_valid(timing);
+}
+
+int main(int argc, char **argv) {
+    uint32_t leds[WIRE_MAX_ARGS];
+    uint32_t led_count = 0;
+    ws2812_wire_timing_t timings[WIRE_MAX_ARGS];
+    uint32_t timing_count = 0;
+    uint32_t chains[WIRE_MAX_ARGS];
+    uint32_t chain_count = 0;
+    uint32_t reset_us = WIRE_DEFAULT_RESET_US;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--leds") == 0 && i + 1 < argc && led_count < WIRE_MAX_ARGS) {
+            leds[led_count] = (uint32_t)strtoul(argv[++i], NULL, 0);
+            if (leds[led_count] == 0 || leds[led_count] > WIRE_MAX_LEDS) {
+                fprintf(stderr, "psl_wire: LED count must be 1..%u\n", WIRE_MAX_LEDS);
+                return 2;
+            }
+            led_count++;
+        } else if (strcmp(argv[i], "--timing") == 0 && i + 1 < argc && timing_count < WIRE_MAX_ARGS) {
+            if (!parse_timing(argv[++i], &timings[timing_count])) {
+                fprintf(stderr, "psl_wire: timing is T1,T2,T3[@bit_hz] with each T 1..16 cycles\n");
+                return 2;
+            }
+            timing_count++;
+        } else if (strcmp(argv[i], "--chains") == 0 && i + 1 < argc && chain_count < WIRE_MAX_ARGS) {
+            chains[chain_count] = (uint32_t)strtoul(argv[++i], NULL, 0);
+            if (chains[chain_count] == 0 || chains[chain_count] > WS2812_MAX_STRIPS) {
+                fprintf(stderr, "psl_wire: chain count must be 1..%u\n", WS2812_MAX_STRIPS);
+                return 2;
+            }
+            chain_count++;
+        } else if (strcmp(argv[i], "--reset-us") == 0 && i + 1 < argc) {
+            reset_us = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr,
+                    "usage: %s [--leds <n>]... [--chains <n>]... [--timing <t1>,<t2>,<t3>[@<bit_hz>]]... "
+                    "[--reset-us <us>]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (led_count == 0) {
+        leds[led_count++] = 300;
+        leds[led_count++] = 1024;
+    }
+    if (chain_count == 0) {
+        chains[chain_count++] = 1;
+        chains[chain_count++] = WS2812_MAX_STRIPS;
+    }
+    if (timing_count == 0) {
+        /* ws2812.pio's set, and the WS2812B-specific one its comment suggests. */
+        timings[timing_count++] = (ws2812_wire_timing_t){3, 3, 4, 800000.0f};
+        timings[timing_count++] = (ws2812_wire_timing_t){7, 10, 8, 800000.0f};
+    }
+
+    bool ok = analyse_firmware(reset_us);
+
+    printf("\n leds  chains  T1/T2/T3  bit kHz  T0H ns  T1H ns  bit ns  wire us   max fps  violations\n");
+    for (uint32_t t = 0; t < timing_count; ++t) {
+        for (uint32_t l = 0; l < led_count; ++l) {
+            for (uint32_t c = 0; c < chain_count; ++c) {
+                analyse_timing(&timings[t], leds[l], chains[c], reset_us);
+            }
+        }
+    }
+    return ok ? 0 : 1;
+}
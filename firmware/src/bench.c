@@ -0,0 +1,464 @@
+#include "bench.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
+
+#include "bitplane.h"
+#include "color.h"
+#include "command_parser.h"
+#include "frame_protocol.h"
+#include "motion_protocol.h"
+#include "pixel_pack.h"
+
+#define BENCH_PIXELS 300u
+#define BENCH_ROUNDS 8u
+#define SYSTICK_MASK 0x00FFFFFFu
+
+static volatile uint32_t bench_sink;
+
+static void bench_cycle_counter_init(void) {
+    systick_hw->rvr = SYSTICK_MASK;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5u; /* enable, clocked from the processor */
+}
+
+static inline uint32_t bench_cycles_now(void) {
+    return systick_hw->cvr;
+}
+
+/* SysTick counts down and wraps at 24 bits; keep each timed block shorter. */
+static inline uint32_t bench_cycles_since(uint32_t start) {
+    return (start - systick_hw->cvr) & SYSTICK_MASK;
+}
+
+static inline float clampf(float value, float min, float max) {
+    if (value < min) {
+        return min;
+    }
+    if (value > max) {
+        return max;
+    }
+    return value;
+}
+
+/* The float conversion the fixed-point kernel replaced, kept as reference. */
+static void hsv_to_rgb_float(float h, float s, float v, uint8_t *r, uint8_t *g, uint8_t *b) {
+    h = fmodf(h, 360.0f);
+    if (h < 0.0f) {
+        h += 360.0f;
+    }
+
+    float c = v * s;
+    float x = c * (1.0f - fabsf(fmodf(h / 60.0f, 2.0f) - 1.0f));
+    float m = v - c;
+    float r1 = 0.0f;
+    float g1 = 0.0f;
+    float b1 = 0.0f;
+
+    if (h < 60.0f) {
+        r1 = c;
+        g1 = x;
+    } else if (h < 120.0f) {
+        r1 = x;
+        g1 = c;
+    } else if (h < 180.0f) {
+        g1 = c;
+        b1 = x;
+    } else if (h < 240.0f) {
+        g1 = x;
+        b1 = c;
+    } else if (h < 300.0f) {
+        r1 = x;
+        b1 = c;
+    } else {
+        r1 = c;
+        b1 = x;
+    }
+
+    *r = (uint8_t)clampf((r1 + m) * 255.0f, 0.0f, 255.0f);
+    *g = (uint8_t)clampf((g1 + m) * 255.0f, 0.0f, 255.0f);
+    *b = (uint8_t)clampf((b1 + m) * 255.0f, 0.0f, 255.0f);
+}
+
+static void bench_report(const char *name, uint32_t best_cycles, uint32_t items) {
+    uint32_t hz = clock_get_hz(clk_sys);
+    uint32_t per_item = best_cycles / items;
+    uint32_t per_sec = best_cycles ? (uint32_t)(((uint64_t)hz * items) / best_cycles) : 0;
+    printf("bench %-20s %8lu cycles / %u = %5lu cycles/item, %lu items/s\n",
+           name, (unsigned long)best_cycles, (unsigned)items,
+           (unsigned long)per_item, (unsigned long)per_sec);
+}
+
+static void bench_hsv_float(void) {
+    uint32_t best = UINT32_MAX;
+    for (uint32_t round = 0; round < BENCH_ROUNDS; ++round) {
+        uint32_t acc = 0;
+        uint32_t start = bench_cycles_now();
+        for (uint32_t i = 0; i < BENCH_PIXELS; ++i) {
+            uint8_t r, g, b;
+            hsv_to_rgb_float((float)(i * 360u) / BENCH_PIXELS, 1.0f, 0.5f, &r, &g, &b);
+            acc += r + g + b;
+        }
+        uint32_t cycles = bench_cycles_since(start);
+        bench_sink = acc;
+        if (cycles < best) {
+            best = cycles;
+        }
+    }
+    bench_report("hsv_to_rgb float", best, BENCH_PIXELS);
+}
+
+static void bench_hsv16(void) {
+    const uint16_t hue_step = (uint16_t)(65536u / BENCH_PIXELS);
+    uint32_t best = UINT32_MAX;
+    for (uint32_t round = 0; round < BENCH_ROUNDS; ++round) {
+        uint32_t acc = 0;
+        uint16_t hue = 0;
+        uint32_t start = bench_cycles_now();
+        for (uint32_t i = 0; i < BENCH_PIXELS; ++i) {
+            color_rgb_t rgb = color_hsv16_to_rgb(hue, 255, 128);
+            acc += rgb.r + rgb.g + rgb.b;
+            hue = (uint16_t)(hue + hue_step);
+        }
+        uint32_t cycles = bench_cycles_since(start);
+        bench_sink = acc;
+        if (cycles < best) {
+            best = cycles;
+        }
+    }
+    bench_report("color_hsv16_to_rgb", best, BENCH_PIXELS);
+    printf("bench %-20s %lu frames/s of %u individually coloured pixels\n", "",
+           (unsigned long)(best ? ((uint64_t)clock_get_hz(clk_sys) / best) : 0), (unsigned)BENCH_PIXELS);
+}
+
+/* Sweep hue exhaustively and S/V in coarse steps against the float reference. */
+static void check_hsv16_accuracy(void) {
+    int max_error = 0;
+    uint32_t mismatches = 0;
+    uint32_t samples = 0;
+    for (uint32_t hue = 0; hue < 65536u; hue += 3u) {
+        for (uint32_t sat = 0; sat < 256u; sat += 51u) {
+            for (uint32_t val = 0; val < 256u; val += 51u) {
+                uint8_t r, g, b;
+                hsv_to_rgb_float((float)hue * (360.0f / 65536.0f), (float)sat / 255.0f,
+                                 (float)val / 255.0f, &r, &g, &b);
+                color_rgb_t rgb = color_hsv16_to_rgb((uint16_t)hue, (uint8_t)sat, (uint8_t)val);
+                int err = abs((int)rgb.r - r);
+                int err_g = abs((int)rgb.g - g);
+                int err_b = abs((int)rgb.b - b);
+                err = err > err_g ? err : err_g;
+                err = err > err_b ? err : err_b;
+                if (err) {
+                    mismatches++;
+                }
+                if (err > max_error) {
+                    max_error = err;
+                }
+                samples++;
+            }
+        }
+    }
+    printf("bench hsv16 accuracy: max error %d LSB, %lu of %lu samples differ\n",
+           max_error, (unsigned long)mismatches, (unsigned long)samples);
+}
+
+static void bench_pixel_pack(void) {
+    static color_rgb_t pixels[BENCH_PIXELS];
+    static uint32_t words[BENCH_PIXELS];
+    for (uint32_t i = 0; i < BENCH_PIXELS; ++i) {
+        pixels[i] = color_hsv16_to_rgb((uint16_t)(i * (65536u / BENCH_PIXELS)), 255, 255);
+    }
+    uint8_t saved_level = pixel_pack_brightness();
+    uint32_t best = UINT32_MAX;
+    for (uint32_t round = 0; round < BENCH_ROUNDS; ++round) {
+        uint32_t start = bench_cycles_now();
+        pixel_pack_set_brightness((uint8_t)(64u + round));
+        pixel_pack_grb(words, pixels, BENCH_PIXELS);
+        uint32_t cycles = bench_cycles_since(start);
+        bench_sink = words[BENCH_PIXELS - 1];
+        if (cycles < best) {
+            best = cycles;
+        }
+    }
+    pixel_pack_set_brightness(saved_level);
+    bench_report("brightness+pack", best, BENCH_PIXELS);
+}
+
+static void bench_dither(void) {
+    static color_rgb_t pixels[BENCH_PIXELS];
+    static color_rgb16_t linear[BENCH_PIXELS];
+    static pixel_dither_error_t error[BENCH_PIXELS];
+    static uint32_t words[BENCH_PIXELS];
+    for (uint32_t i = 0; i < BENCH_PIXELS; ++i) {
+        pixels[i] = color_hsv16_to_rgb((uint16_t)(i * (65536u / BENCH_PIXELS)), 255, 255);
+    }
+    uint8_t saved_level = pixel_pack_brightness();
+    pixel_pack_set_brightness(13); /* the 5% floor */
+    pixel_pack_dither_reset(error, BENCH_PIXELS);
+
+    uint32_t best_linearize = UINT32_MAX;
+    uint32_t best_refresh = UINT32_MAX;
+    for (uint32_t round = 0; round < BENCH_ROUNDS; ++round) {
+        uint32_t start = bench_cycles_now();
+        pixel_pack_linearize(linear, pixels, BENCH_PIXELS);
+        uint32_t cycles = bench_cycles_since(start);
+        if (cycles < best_linearize) {
+            best_linearize = cycles;
+        }
+        start = bench_cycles_now();
+        pixel_pack_grb_dithered(words, linear, error, BENCH_PIXELS);
+        cycles = bench_cycles_since(start);
+        bench_sink = words[BENCH_PIXELS / 2];
+        if (cycles < best_refresh) {
+            best_refresh = cycles;
+        }
+    }
+    pixel_pack_set_brightness(saved_level);
+    bench_report("dither linearize", best_linearize, BENCH_PIXELS);
+    bench_report("dither refresh", best_refresh, BENCH_PIXELS);
+}
+
+/* The strip split over 8 lanes, transposed as the parallel output does. */
+static void bench_transpose(void) {
+    static uint32_t words[BENCH_PIXELS];
+    static uint32_t planes[(BENCH_PIXELS / BITPLANE_LANES + 1u) * BITPLANE_WORDS_PER_ROW];
+    uint16_t lane_start[BITPLANE_LANES];
+    uint16_t lane_len[BITPLANE_LANES];
+    uint16_t rows = 0;
+    for (uint32_t i = 0; i < BENCH_PIXELS; ++i) {
+        words[i] = color_rgb_to_grb(color_hsv16_to_rgb((uint16_t)(i * (65536u / BENCH_PIXELS)), 255, 255)) << 8;
+    }
+    for (uint32_t lane = 0; lane < BITPLANE_LANES; ++lane) {
+        lane_start[lane] = (uint16_t)(lane * BENCH_PIXELS / BITPLANE_LANES);
+        lane_len[lane] = (uint16_t)((lane + 1u) * BENCH_PIXELS / BITPLANE_LANES - lane_start[lane]);
+        if (lane_len[lane] > rows) {
+            rows = lane_len[lane];
+        }
+    }
+    uint32_t best = UINT32_MAX;
+    for (uint32_t round = 0; round < BENCH_ROUNDS; ++round) {
+        uint32_t start = bench_cycles_now();
+        bitplane_transpose(planes, words, lane_start, lane_len, BITPLANE_LANES, rows);
+        uint32_t cycles = bench_cycles_since(start);
+        bench_sink = planes[rows * BITPLANE_WORDS_PER_ROW - 1u];
+        if (cycles < best) {
+            best = cycles;
+        }
+    }
+    bench_report("bitplane transpose", best, BENCH_PIXELS);
+}
+
+#define BENCH_FRAME_RUNS 50u
+#define BENCH_FRAME_LEN (PSL_FRAME_HEADER_LEN + BENCH_FRAME_RUNS * PSL_FRAME_RUN_LEN)
+
+/* Decode and paint a 50-run 0xA0 frame covering the whole strip. */
+static void bench_frame_parse(void) {
+    static uint8_t frame[BENCH_FRAME_LEN];
+    static color_rgb_t pixels[BENCH_PIXELS];
+    const uint16_t run_len = (uint16_t)(BENCH_PIXELS / BENCH_FRAME_RUNS);
+    frame[0] = PSL_FRAME_COMMAND_ID;
+    frame[1] = PSL_FRAME_VERSION;
+    frame[2] = (uint8_t)BENCH_FRAME_RUNS;
+    uint8_t *p = frame + PSL_FRAME_HEADER_LEN;
+    for (uint32_t i = 0; i < BENCH_FRAME_RUNS; ++i) {
+        uint16_t start = (uint16_t)(i * run_len);
+        color_rgb_t rgb = color_hsv16_to_rgb((uint16_t)(i * (65536u / BENCH_FRAME_RUNS)), 255, 255);
+        p[0] = (uint8_t)start;
+        p[1] = (uint8_t)(start >> 8);
+        p[2] = (uint8_t)run_len;
+        p[3] = (uint8_t)(run_len >> 8);
+        p[4] = rgb.r;
+        p[5] = rgb.g;
+        p[6] = rgb.b;
+        p += PSL_FRAME_RUN_LEN;
+    }
+
+    uint32_t best = UINT32_MAX;
+    for (uint32_t round = 0; round < BENCH_ROUNDS; ++round) {
+        uint32_t start = bench_cycles_now();
+        frame_reader_t reader;
+        frame_run_t run;
+        if (frame_reader_init(&reader, frame, sizeof(frame)) == FRAME_PARSE_OK) {
+            while (frame_reader_next(&reader, &run)) {
+                frame_apply_run(pixels, BENCH_PIXELS, &run);
+            }
+        }
+        uint32_t cycles = bench_cycles_since(start);
+        bench_sink = pixels[BENCH_PIXELS - 1].g;
+        if (cycles < best) {
+            best = cycles;
+        }
+    }
+    bench_report("0xA0 parse+apply", best, BENCH_FRAME_RUNS);
+    printf("bench %-20s %u bytes/frame, %lu bytes/s\n", "", (unsigned)BENCH_FRAME_LEN,
+           (unsigned long)(best ? ((uint64_t)clock_get_hz(clk_sys) * BENCH_FRAME_LEN / best) : 0));
+}
+
+/* The sscanf cascade command_parse_text() replaced, kept as reference. */
+static int parse_text_sscanf(const uint8_t *packet, size_t len, psl_command_t *command) {
+    char buffer[128];
+    size_t copy_len = len < sizeof(buffer) - 1 ? len : sizeof(buffer) - 1;
+    memcpy(buffer, packet, copy_len);
+    buffer[copy_len] = '\0';
+
+    if (strncmp(buffer, "RESET", 5) == 0) {
+        return COMMAND_PARSE_RESET;
+    }
+    if (sscanf(buffer, "H_SET,%f", &command->u.value) == 1 ||
+        sscanf(buffer, "B_SET,%f", &command->u.value) == 1 ||
+        sscanf(buffer, "H,%f", &command->u.value) == 1 ||
+        sscanf(buffer, "B,%f", &command->u.value) == 1) {
+        return COMMAND_PARSE_OK;
+    }
+    unsigned long segment_idx = 0;
+    if (sscanf(buffer, "SEG_START,%lu", &segment_idx) == 1 ||
+        sscanf(buffer, "SEG_END,%lu", &segment_idx) == 1) {
+        command->u.index = segment_idx > 0 ? (uint32_t)(segment_idx - 1) : 0;
+        return COMMAND_PARSE_OK;
+    }
+    if (sscanf(buffer, "%f,%f,%f", &command->u.motion.pitch, &command->u.motion.roll,
+               &command->u.motion.yaw) == 3) {
+        return COMMAND_PARSE_OK;
+    }
+    return COMMAND_PARSE_UNRECOGNIZED;
+}
+
+static const char *const bench_text_packets[] = {
+    "0.123,-1.570,3.141",
+    "H_SET,212.5",
+    "B_SET,75",
+    "H,-4.25",
+    "B,0.02",
+    "SEG_START,12",
+    "SEG_END,288",
+};
+
+static uint32_t bench_text_parser(int (*parse)(const uint8_t *, size_t, psl_command_t *),
+                                  const char *packet) {
+    size_t len = strlen(packet);
+    uint32_t best = UINT32_MAX;
+    for (uint32_t round = 0; round < BENCH_ROUNDS; ++round) {
+        psl_command_t command;
+        uint32_t start = bench_cycles_now();
+        int result = parse((const uint8_t *)packet, len, &command);
+        uint32_t cycles = bench_cycles_since(start);
+        bench_sink = (uint32_t)result + command.u.index;
+        if (cycles < best) {
+            best = cycles;
+        }
+    }
+    return best;
+}
+
+static int parse_text_onepass(const uint8_t *packet, size_t len, psl_command_t *command) {
+    return (int)command_parse_text(packet, len, command);
+}
+
+static void bench_command_parse(void) {
+    printf("bench %-20s %8s %8s cycles/packet\n", "text command", "sscanf", "1-pass");
+    for (size_t i = 0; i < sizeof(bench_text_packets) / sizeof(bench_text_packets[0]); ++i) {
+        const char *packet = bench_text_packets[i];
+        uint32_t legacy = bench_text_parser(parse_text_sscanf, packet);
+        uint32_t onepass = bench_text_parser(parse_text_onepass, packet);
+        printf("bench %-20s %8lu %8lu\n", packet, (unsigned long)legacy, (unsigned long)onepass);
+    }
+}
+
+/* 0xA2 with sequence + timestamp, decoded and converted to the float command. */
+static void bench_motion_decode(void) {
+    static const uint8_t packet[] = {
+        PSL_MOTION_COMMAND_ID, PSL_MOTION_FLAG_SEQ | PSL_MOTION_FLAG_TIMESTAMP,
+        0xf0, 0x03, 0xc3, 0xcd, 0x83, 0x64, /* 0.123, -1.570, 3.141 rad */
+        0x2a, 0x00, 0x10, 0x27, 0x00, 0x00,
+    };
+    uint32_t best = UINT32_MAX;
+    for (uint32_t round = 0; round < BENCH_ROUNDS; ++round) {
+        motion_packet_t decoded;
+        psl_command_t command;
+        uint32_t start = bench_cycles_now();
+        if (motion_packet_decode(packet, sizeof(packet), &decoded) == MOTION_PARSE_OK) {
+            command.u.motion.pitch = motion_angle_to_radians(decoded.pitch);
+            command.u.motion.roll = motion_angle_to_radians(decoded.roll);
+            command.u.motion.yaw = motion_angle_to_radians(decoded.yaw);
+        }
+        uint32_t cycles = bench_cycles_since(start);
+        bench_sink = command.u.index;
+        if (cycles < best) {
+            best = cycles;
+        }
+    }
+    printf("bench %-20s %8s %8lu (%u bytes)\n", "0xA2 motion", "-", (unsigned long)best,
+           (unsigned)sizeof(packet));
+}
+
+#define BENCH_DELTA_BITMAP_LEN ((BENCH_FRAME_RUNS * 3u + 7u) / 8u)
+#define BENCH_DELTA_LEN (PSL_FRAME_DELTA_HEADER_LEN + BENCH_DELTA_BITMAP_LEN + BENCH_FRAME_RUNS)
+
+/* One drifting channel per run, the shape of the app's rainbow animation. */
+static void bench_frame_delta(void) {
+    static frame_base_t base;
+    static uint8_t delta[BENCH_DELTA_LEN];
+    static color_rgb_t pixels[BENCH_PIXELS];
+    const uint16_t run_len = (uint16_t)(BENCH_PIXELS / BENCH_FRAME_RUNS);
+    frame_base_begin(&base);
+    for (uint32_t i = 0; i < BENCH_FRAME_RUNS; ++i) {
+        frame_run_t run = {
+            (uint16_t)(i * run_len), run_len,
+            color_hsv16_to_rgb((uint16_t)(i * (65536u / BENCH_FRAME_RUNS)), 255, 255),
+        };
+        frame_base_append(&base, &run);
+    }
+    memset(delta, 0, sizeof(delta));
+    delta[0] = PSL_FRAME_DELTA_COMMAND_ID;
+    delta[1] = PSL_FRAME_VERSION;
+    delta[3] = (uint8_t)BENCH_FRAME_RUNS;
+    uint8_t *bitmap = delta + PSL_FRAME_DELTA_HEADER_LEN;
+    uint8_t *deltas = bitmap + BENCH_DELTA_BITMAP_LEN;
+    for (uint32_t i = 0; i < BENCH_FRAME_RUNS; ++i) {
+        uint32_t bit = i * 3u + (i % 3u);
+        bitmap[bit >> 3] |= (uint8_t)(1u << (bit & 7u));
+        deltas[i] = (i & 1u) ? 0xFB : 0x05;
+    }
+
+    uint32_t best = UINT32_MAX;
+    for (uint32_t round = 0; round < BENCH_ROUNDS; ++round) {
+        delta[2] = (uint8_t)(base.delta_seq + 1u);
+        uint32_t start = bench_cycles_now();
+        frame_delta_reader_t reader;
+        frame_run_t run;
+        if (frame_delta_reader_init(&reader, &base, delta, sizeof(delta)) == FRAME_PARSE_OK) {
+            while (frame_delta_reader_next(&reader, &run)) {
+                frame_apply_run(pixels, BENCH_PIXELS, &run);
+            }
+        }
+        uint32_t cycles = bench_cycles_since(start);
+        bench_sink = pixels[BENCH_PIXELS / 2].r;
+        if (cycles < best) {
+            best = cycles;
+        }
+    }
+    bench_report("0xA3 delta+apply", best, BENCH_FRAME_RUNS);
+    printf("bench %-20s %u bytes/frame vs %u full\n", "", (unsigned)BENCH_DELTA_LEN,
+           (unsigned)BENCH_FRAME_LEN);
+}
+
+void bench_run_all(void) {
+    bench_cycle_counter_init();
+    printf("bench: clk_sys %lu Hz\n", (unsigned long)clock_get_hz(clk_sys));
+    bench_hsv_float();
+    bench_hsv16();
+    check_hsv16_accuracy();
+    bench_pixel_pack();
+    bench_dither();
+    bench_transpose();
+    bench_frame_parse();
+    bench_frame_delta();
+    bench_command_parse();
+    bench_motion_decode();
+}
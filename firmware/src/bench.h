@@ -0,0 +1,13 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/*
+ * On-target kernel benchmarks, built in with -DPSL_ENABLE_BENCHMARKS=ON.
+ * Cycle counts come from SysTick clocked at clk_sys and are printed over USB
+ * stdio before the BLE stack starts. host/bench/psl_bench.c times the same
+ * kernels on the host for quick before/after comparisons.
+ */
+
+void bench_run_all(void);
+
+#endif
@@ -0,0 +1,53 @@
+#include "bitplane.h"
+
+/*
+ * 8x8 bit-matrix transpose (Hacker's Delight, transpose8rS32) on one byte
+ * of each lane. x holds lanes 7..4 and y lanes 3..0, most significant byte
+ * first, so output byte i is bit (7 - i) of every lane with lane l at bit l.
+ */
+static inline void transpose_byte(uint32_t *planes, const uint32_t grb[BITPLANE_LANES], uint32_t shift) {
+    uint32_t x = ((grb[7] >> shift) & 0xffu) << 24 | ((grb[6] >> shift) & 0xffu) << 16 |
+                 ((grb[5] >> shift) & 0xffu) << 8 | ((grb[4] >> shift) & 0xffu);
+    uint32_t y = ((grb[3] >> shift) & 0xffu) << 24 | ((grb[2] >> shift) & 0xffu) << 16 |
+                 ((grb[1] >> shift) & 0xffu) << 8 | ((grb[0] >> shift) & 0xffu);
+    uint32_t t;
+
+    t = (x ^ (x >> 7)) & 0x00aa00aau;
+    x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00aa00aau;
+    y = y ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000ccccu;
+    x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000ccccu;
+    y = y ^ t ^ (t << 14);
+    t = (x & 0xf0f0f0f0u) | ((y >> 4) & 0x0f0f0f0fu);
+    y = ((x << 4) & 0xf0f0f0f0u) | (y & 0x0f0f0f0fu);
+    x = t;
+
+    planes[0] = x >> 24;
+    planes[1] = (x >> 16) & 0xffu;
+    planes[2] = (x >> 8) & 0xffu;
+    planes[3] = x & 0xffu;
+    planes[4] = y >> 24;
+    planes[5] = (y >> 16) & 0xffu;
+    planes[6] = (y >> 8) & 0xffu;
+    planes[7] = y & 0xffu;
+}
+
+void bitplane_transpose_row(uint32_t *planes, const uint32_t grb[BITPLANE_LANES]) {
+    transpose_byte(planes, grb, 24);
+    transpose_byte(planes + 8, grb, 16);
+    transpose_byte(planes + 16, grb, 8);
+}
+
+void bitplane_transpose(uint32_t *planes, const uint32_t *src, const uint16_t *lane_start,
+                        const uint16_t *lane_len, uint32_t lane_count, uint16_t rows) {
+    uint32_t row_grb[BITPLANE_LANES] = {0};
+    for (uint16_t row = 0; row < rows; ++row) {
+        for (uint32_t lane = 0; lane < lane_count; ++lane) {
+            row_grb[lane] = row < lane_len[lane] ? src[lane_start[lane] + row] : 0u;
+        }
+        bitplane_transpose_row(planes, row_grb);
+        planes += BITPLANE_WORDS_PER_ROW;
+    }
+}
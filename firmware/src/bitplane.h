@@ -0,0 +1,28 @@
+#ifndef BITPLANE_H
+#define BITPLANE_H
+
+#include <stdint.h>
+
+/*
+ * Bit-plane transpose for the ws2812_parallel PIO program. One row is the
+ * n-th pixel of every lane; it becomes 24 words, one per bit time, MSB
+ * first (G7..G0, R7..R0, B7..B0). Bit l of each word is lane l's bit, so
+ * the state machine drives all lanes from a single OUT.
+ */
+
+#define BITPLANE_LANES 8u
+#define BITPLANE_WORDS_PER_ROW 24u
+
+/* grb[l] is lane l's PIO word (GRB in the top 24 bits, as pixel_pack_grb()
+ * writes them). */
+void bitplane_transpose_row(uint32_t *planes, const uint32_t grb[BITPLANE_LANES]);
+
+/*
+ * A whole frame: lane l's pixels are src[lane_start[l]], continuing for
+ * lane_len[l] entries. Writes rows * BITPLANE_WORDS_PER_ROW words; lanes
+ * past lane_count, and rows past a lane's end, are sent as black.
+ */
+void bitplane_transpose(uint32_t *planes, const uint32_t *src, const uint16_t *lane_start,
+                        const uint16_t *lane_len, uint32_t lane_count, uint16_t rows);
+
+#endif
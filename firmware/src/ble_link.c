@@ -0,0 +1,228 @@
+#include "ble_link.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "btstack_event.h"
+#include "log_ring.h"
+
+#define LE_PHY_MASK_2M 0x02u
+#define DEFAULT_ATT_MTU 23u
+#define DEFAULT_LL_OCTETS 27u
+#define L2CAP_HEADER_LEN 4u
+
+#ifdef HCI_ACL_PAYLOAD_SIZE
+_Static_assert(HCI_ACL_PAYLOAD_SIZE >= BLE_LINK_MAX_MTU + L2CAP_HEADER_LEN,
+               "HCI_ACL_PAYLOAD_SIZE too small for BLE_LINK_MAX_MTU");
+#endif
+
+static ble_link_state_t link;
+static btstack_timer_source_t idle_timer;
+static btstack_packet_callback_registration_t l2cap_event_cb;
+static uint32_t reported_bytes;
+static uint32_t reported_writes;
+static uint32_t peak_bytes_per_sec;
+
+static const char *phy_name(uint8_t phy) {
+    switch (phy) {
+    case 1:
+        return "1M";
+    case 2:
+        return "2M";
+    case 3:
+        return "Coded";
+    default:
+        return "?";
+    }
+}
+
+static void reset_link(hci_con_handle_t handle) {
+    memset(&link, 0, sizeof(link));
+    link.handle = handle;
+    link.mtu = DEFAULT_ATT_MTU;
+    link.tx_octets = DEFAULT_LL_OCTETS;
+    link.rx_octets = DEFAULT_LL_OCTETS;
+    link.tx_phy = 1;
+    link.rx_phy = 1;
+    reported_bytes = 0;
+    reported_writes = 0;
+    peak_bytes_per_sec = 0;
+}
+
+static void request_fast_link(hci_con_handle_t handle) {
+    uint8_t status = gap_le_set_data_length(handle, BLE_LINK_MAX_TX_OCTETS, BLE_LINK_MAX_TX_TIME_US);
+    if (status != ERROR_CODE_SUCCESS) {
+        PSL_LOG_WARN("Link 0x%04x: data length request failed (0x%02x)\n", handle, status);
+    }
+    status = gap_le_set_phy(handle, 0, LE_PHY_MASK_2M, LE_PHY_MASK_2M, 0);
+    if (status != ERROR_CODE_SUCCESS) {
+        PSL_LOG_WARN("Link 0x%04x: 2M PHY request failed (0x%02x)\n", handle, status);
+    }
+}
+
+static void request_connection_parameters(bool streaming) {
+    if (link.handle == HCI_CON_HANDLE_INVALID) {
+        return;
+    }
+    link.streaming = streaming;
+    int status;
+    if (streaming) {
+        status = gap_request_connection_parameter_update(link.handle, BLE_LINK_FAST_INTERVAL_MIN,
+                                                         BLE_LINK_FAST_INTERVAL_MAX, BLE_LINK_FAST_LATENCY,
+                                                         BLE_LINK_SUPERVISION_TIMEOUT);
+    } else {
+        status = gap_request_connection_parameter_update(link.handle, BLE_LINK_RELAXED_INTERVAL_MIN,
+                                                         BLE_LINK_RELAXED_INTERVAL_MAX, BLE_LINK_RELAXED_LATENCY,
+                                                         BLE_LINK_SUPERVISION_TIMEOUT);
+    }
+    if (status != ERROR_CODE_SUCCESS) {
+        PSL_LOG_WARN("Link 0x%04x: connection parameter request failed (%d)\n", link.handle, status);
+    }
+}
+
+static void idle_timer_handler(btstack_timer_source_t *ts) {
+    if (link.handle == HCI_CON_HANDLE_INVALID) {
+        return;
+    }
+    if (link.streaming && btstack_run_loop_get_time_ms() - link.last_write_ms >= BLE_LINK_IDLE_MS) {
+        request_connection_parameters(false);
+    }
+    btstack_run_loop_set_timer(ts, BLE_LINK_IDLE_MS / 2u);
+    btstack_run_loop_add_timer(ts);
+}
+
+static void log_connection_parameters(const char *what) {
+    PSL_LOG_INFO("Link %s interval %lu us, latency %u, timeout %u ms\n", what,
+                 ble_link_interval_us(), link.latency, link.supervision_timeout * 10u);
+}
+
+static void handle_le_meta(const uint8_t *packet) {
+    switch (hci_event_le_meta_get_subevent_code(packet)) {
+    case HCI_SUBEVENT_LE_CONNECTION_COMPLETE:
+        if (hci_subevent_le_connection_complete_get_status(packet) == ERROR_CODE_SUCCESS) {
+            reset_link(hci_subevent_le_connection_complete_get_connection_handle(packet));
+            link.interval = hci_subevent_le_connection_complete_get_conn_interval(packet);
+            link.latency = hci_subevent_le_connection_complete_get_conn_latency(packet);
+            link.supervision_timeout = hci_subevent_le_connection_complete_get_supervision_timeout(packet);
+            log_connection_parameters("connected,");
+            request_fast_link(link.handle);
+            btstack_run_loop_remove_timer(&idle_timer);
+            btstack_run_loop_set_timer(&idle_timer, BLE_LINK_IDLE_MS / 2u);
+            btstack_run_loop_add_timer(&idle_timer);
+        }
+        break;
+    case HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE:
+        if (hci_subevent_le_connection_update_complete_get_status(packet) == ERROR_CODE_SUCCESS) {
+            link.interval = hci_subevent_le_connection_update_complete_get_conn_interval(packet);
+            link.latency = hci_subevent_le_connection_update_complete_get_conn_latency(packet);
+            link.supervision_timeout = hci_subevent_le_connection_update_complete_get_supervision_timeout(packet);
+            log_connection_parameters("updated,");
+        }
+        break;
+    case HCI_SUBEVENT_LE_DATA_LENGTH_CHANGE:
+        link.tx_octets = hci_subevent_le_data_length_change_get_max_tx_octets(packet);
+        link.rx_octets = hci_subevent_le_data_length_change_get_max_rx_octets(packet);
+        PSL_LOG_INFO("Link data length tx %u octets/%u us, rx %u octets/%u us\n",
+                     link.tx_octets, hci_subevent_le_data_length_change_get_max_tx_time(packet),
+                     link.rx_octets, hci_subevent_le_data_length_change_get_max_rx_time(packet));
+        break;
+    case HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE: {
+        uint8_t status = hci_subevent_le_phy_update_complete_get_status(packet);
+        if (status == ERROR_CODE_SUCCESS) {
+            link.tx_phy = hci_subevent_le_phy_update_complete_get_tx_phy(packet);
+            link.rx_phy = hci_subevent_le_phy_update_complete_get_rx_phy(packet);
+        }
+        PSL_LOG_INFO("Link 0x%04x: PHY update status 0x%02x, tx %s rx %s\n",
+                     hci_subevent_le_phy_update_complete_get_connection_handle(packet), status,
+                     phy_name(link.tx_phy), phy_name(link.rx_phy));
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static void l2cap_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size) {
+    (void)channel;
+    if (packet_type == HCI_EVENT_PACKET &&
+        hci_event_packet_get_type(packet) == L2CAP_EVENT_CONNECTION_PARAMETER_UPDATE_RESPONSE) {
+        ble_link_handle_event(packet_type, packet, size);
+    }
+}
+
+void ble_link_init(void) {
+    reset_link(HCI_CON_HANDLE_INVALID);
+    btstack_run_loop_set_timer_handler(&idle_timer, &idle_timer_handler);
+    /* Connection parameter update responses are L2CAP signalling events. */
+    l2cap_event_cb.callback = &l2cap_event_handler;
+    l2cap_add_event_handler(&l2cap_event_cb);
+    l2cap_set_max_le_mtu(BLE_LINK_MAX_MTU);
+}
+
+void ble_link_handle_event(uint8_t packet_type, uint8_t *packet, uint16_t size) {
+    (void)size;
+    if (packet_type != HCI_EVENT_PACKET) {
+        return;
+    }
+    switch (hci_event_packet_get_type(packet)) {
+    case HCI_EVENT_LE_META:
+        handle_le_meta(packet);
+        break;
+    case ATT_EVENT_MTU_EXCHANGE_COMPLETE:
+        link.mtu = att_event_mtu_exchange_complete_get_MTU(packet);
+        PSL_LOG_INFO("Link 0x%04x: ATT MTU %u (%u-byte writes)\n",
+                     att_event_mtu_exchange_complete_get_handle(packet), link.mtu, link.mtu - 3u);
+        break;
+    case L2CAP_EVENT_CONNECTION_PARAMETER_UPDATE_RESPONSE:
+        if (l2cap_event_connection_parameter_update_response_get_result(packet) != 0) {
+            PSL_LOG_WARN("Link 0x%04x: central rejected %s connection parameters\n",
+                         l2cap_event_connection_parameter_update_response_get_handle(packet),
+                         link.streaming ? "streaming" : "idle");
+        }
+        break;
+    case HCI_EVENT_DISCONNECTION_COMPLETE:
+        btstack_run_loop_remove_timer(&idle_timer);
+        reset_link(HCI_CON_HANDLE_INVALID);
+        break;
+    default:
+        break;
+    }
+}
+
+void ble_link_note_write(uint16_t len) {
+    link.rx_bytes += len;
+    link.rx_writes++;
+    link.last_write_ms = btstack_run_loop_get_time_ms();
+    if (!link.streaming) {
+        request_connection_parameters(true);
+    }
+}
+
+void ble_link_report(uint32_t period_ms) {
+    uint32_t bytes = link.rx_bytes - reported_bytes;
+    uint32_t writes = link.rx_writes - reported_writes;
+    if (link.handle == HCI_CON_HANDLE_INVALID || writes == 0 || period_ms == 0) {
+        return;
+    }
+    reported_bytes = link.rx_bytes;
+    reported_writes = link.rx_writes;
+    uint32_t bytes_per_sec = (uint32_t)(((uint64_t)bytes * 1000u) / period_ms);
+    if (bytes_per_sec > peak_bytes_per_sec) {
+        peak_bytes_per_sec = bytes_per_sec;
+    }
+    PSL_LOG_INFO("Link 0x%04x: %lu B/s in %lu writes/s (peak %lu B/s)\n",
+                 link.handle,
+                 (unsigned long)bytes_per_sec,
+                 (unsigned long)(((uint64_t)writes * 1000u) / period_ms),
+                 (unsigned long)peak_bytes_per_sec);
+    PSL_LOG_INFO("Link 0x%04x: MTU %u, LL %u/%u octets\n", link.handle, link.mtu, link.tx_octets, link.rx_octets);
+    PSL_LOG_INFO("Link 0x%04x: PHY %s/%s, interval %lu us\n", link.handle, phy_name(link.tx_phy),
+                 phy_name(link.rx_phy), (unsigned long)ble_link_interval_us());
+}
+
+uint32_t ble_link_interval_us(void) {
+    return link.handle == HCI_CON_HANDLE_INVALID ? 0 : (uint32_t)link.interval * 1250u;
+}
+
+const ble_link_state_t *ble_link_state(void) {
+    return &link;
+}
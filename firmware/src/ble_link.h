@@ -0,0 +1,63 @@
+#ifndef BLE_LINK_H
+#define BLE_LINK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "btstack.h"
+
+/*
+ * Link-layer tuning for the single central connection: on connect the
+ * peripheral asks for LE Data Length Extension (251-byte PDUs) and the 2M
+ * PHY, and advertises the largest ATT MTU so the central's MTU exchange can
+ * go all the way up. The agreed parameters and the achieved write
+ * throughput are logged.
+ */
+
+#define BLE_LINK_MAX_MTU 517u
+#define BLE_LINK_MAX_TX_OCTETS 251u
+#define BLE_LINK_MAX_TX_TIME_US 2120u
+
+/* Connection interval units are 1.25 ms, supervision timeout units 10 ms. */
+#define BLE_LINK_FAST_INTERVAL_MIN 6u      /* 7.5 ms */
+#define BLE_LINK_FAST_INTERVAL_MAX 12u     /* 15 ms */
+#define BLE_LINK_FAST_LATENCY 0u
+#define BLE_LINK_RELAXED_INTERVAL_MIN 24u  /* 30 ms */
+#define BLE_LINK_RELAXED_INTERVAL_MAX 40u  /* 50 ms */
+#define BLE_LINK_RELAXED_LATENCY 4u
+#define BLE_LINK_SUPERVISION_TIMEOUT 400u  /* 4 s */
+#define BLE_LINK_IDLE_MS 2000u
+
+typedef struct {
+    hci_con_handle_t handle;
+    uint16_t mtu;
+    uint16_t tx_octets;
+    uint16_t rx_octets;
+    uint8_t tx_phy;
+    uint8_t rx_phy;
+    uint16_t interval;     /* 1.25 ms units, as negotiated */
+    uint16_t latency;
+    uint16_t supervision_timeout;
+    bool streaming;        /* fast parameters requested */
+    uint32_t last_write_ms;
+    uint32_t rx_bytes;
+    uint32_t rx_writes;
+} ble_link_state_t;
+
+void ble_link_init(void);
+
+/* Feed every HCI event and ATT server event through here. */
+void ble_link_handle_event(uint8_t packet_type, uint8_t *packet, uint16_t size);
+
+/* Count one GATT write of len bytes toward throughput; also marks the link
+ * as streaming. */
+void ble_link_note_write(uint16_t len);
+
+/* Log throughput since the last call; period_ms is the reporting interval. */
+void ble_link_report(uint32_t period_ms);
+
+const ble_link_state_t *ble_link_state(void);
+
+/* Negotiated connection interval in microseconds, 0 when disconnected. */
+uint32_t ble_link_interval_us(void);
+
+#endif
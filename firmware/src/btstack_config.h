@@ -14,18 +14,21 @@
 #ifndef ENABLE_LE_SIGNED_WRITE
 #define ENABLE_LE_SIGNED_WRITE
 #endif
-
-#ifndef ENABLE_LOG_INFO
-#define ENABLE_LOG_INFO
+#ifndef ENABLE_LE_DATA_LENGTH_EXTENSION
+#define ENABLE_LE_DATA_LENGTH_EXTENSION
 #endif
-#ifndef ENABLE_LOG_DEBUG
-#define ENABLE_LOG_DEBUG
+
+/* BTstack's own logging prints synchronously from the radio callbacks; keep
+ * it to errors and leave the rest to log_ring.h. */
+#ifndef ENABLE_LOG_ERROR
+#define ENABLE_LOG_ERROR
 #endif
 
 #ifndef MAX_ATT_DB_SIZE
 #define MAX_ATT_DB_SIZE 1024
 #endif
 
+/* Must hold a max-size ATT PDU (517) plus the L2CAP header; see ble_link.c */
 #ifndef HCI_ACL_PAYLOAD_SIZE
 #define HCI_ACL_PAYLOAD_SIZE 1024
 #endif
@@ -47,6 +50,3 @@
 #endif
 
 #endif
-#ifndef ENABLE_PRINTF_HEXDUMP
-#define ENABLE_PRINTF_HEXDUMP
-#endif
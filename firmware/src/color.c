@@ -0,0 +1,57 @@
+#include "color.h"
+
+/*
+ * For each 60 degree sector, which of {chroma, ramp, zero} lands in r, g, b.
+ * Even sectors ramp up, odd sectors ramp down.
+ */
+static const uint8_t hsv_sector_lanes[6][3] = {
+    {0, 1, 2},
+    {1, 0, 2},
+    {2, 0, 1},
+    {2, 1, 0},
+    {1, 2, 0},
+    {0, 2, 1},
+};
+
+/* floor(x / 255) for x in [0, 255 * 255], without a divide. */
+static inline uint8_t div255(uint32_t x) {
+    return (uint8_t)((x * 257u + 257u) >> 16);
+}
+
+color_rgb_t color_hsv16_to_rgb(uint16_t hue, uint8_t sat, uint8_t val) {
+    uint32_t scaled = (uint32_t)hue * 6u;
+    uint32_t sector = scaled >> 16;
+    uint32_t frac = scaled & 0xFFFFu;
+
+    /* Everything below is in units of 1/(255*255). */
+    uint32_t chroma = (uint32_t)val * sat;
+    uint32_t base = (uint32_t)val * (255u - sat);
+    uint32_t ramp = (chroma * frac) >> 16;
+    if (sector & 1u) {
+        ramp = chroma - ramp;
+    }
+
+    const uint32_t lanes[3] = {chroma + base, ramp + base, base};
+    const uint8_t *map = hsv_sector_lanes[sector];
+    color_rgb_t out = {
+        div255(lanes[map[0]]),
+        div255(lanes[map[1]]),
+        div255(lanes[map[2]]),
+    };
+    return out;
+}
+
+uint16_t color_hue16_from_degrees(float degrees) {
+    int32_t turns = (int32_t)(degrees * COLOR_HUE16_PER_DEGREE);
+    return (uint16_t)((uint32_t)turns & 0xFFFFu);
+}
+
+uint8_t color_unit_to_u8(float unit) {
+    if (unit <= 0.0f) {
+        return 0;
+    }
+    if (unit >= 1.0f) {
+        return 255;
+    }
+    return (uint8_t)(unit * 255.0f + 0.5f);
+}
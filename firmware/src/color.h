@@ -0,0 +1,40 @@
+#ifndef COLOR_H
+#define COLOR_H
+
+#include <stdint.h>
+
+/*
+ * Integer colour kernels. Hue is a full-turn 16-bit angle (65536 == 360
+ * degrees), saturation and value are 0..255. No floats and no divisions, so
+ * they are cheap enough to run per pixel on the Cortex-M0+.
+ */
+
+#define COLOR_HUE16_PER_DEGREE (65536.0f / 360.0f)
+
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} color_rgb_t;
+
+/* Linear-light channel values, 0..65535. */
+typedef struct {
+    uint16_t r;
+    uint16_t g;
+    uint16_t b;
+} color_rgb16_t;
+
+/* Matches the float hsv_to_rgb() it replaces to within 1 LSB per channel. */
+color_rgb_t color_hsv16_to_rgb(uint16_t hue, uint8_t sat, uint8_t val);
+
+/* Convert a hue in degrees (any range) to the 16-bit hue angle. */
+uint16_t color_hue16_from_degrees(float degrees);
+
+/* Convert a 0..1 fraction to 0..255, rounding to nearest and clamping. */
+uint8_t color_unit_to_u8(float unit);
+
+static inline uint32_t color_rgb_to_grb(color_rgb_t rgb) {
+    return ((uint32_t)rgb.g << 16) | ((uint32_t)rgb.r << 8) | rgb.b;
+}
+
+#endif
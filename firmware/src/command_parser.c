@@ -0,0 +1,241 @@
+#include "command_parser.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+/* Significant digits kept in the mantissa; more than float can represent. */
+#define PARSE_MAX_DIGITS 9
+#define PARSE_MAX_EXPONENT 38
+
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+} text_cursor_t;
+
+static const float pow10_table[] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f,
+};
+
+static inline bool is_digit(uint8_t c) {
+    return (uint8_t)(c - '0') < 10u;
+}
+
+static void skip_spaces(text_cursor_t *cur) {
+    while (cur->p < cur->end && (*cur->p == ' ' || *cur->p == '\t')) {
+        cur->p++;
+    }
+}
+
+static bool match_literal(text_cursor_t *cur, const char *literal) {
+    size_t n = strlen(literal);
+    if ((size_t)(cur->end - cur->p) < n || memcmp(cur->p, literal, n) != 0) {
+        return false;
+    }
+    cur->p += n;
+    return true;
+}
+
+static float scale_pow10(float value, int exponent) {
+    while (exponent > 10) {
+        value *= 1e10f;
+        exponent -= 10;
+    }
+    while (exponent < -10) {
+        value /= 1e10f;
+        exponent += 10;
+    }
+    return exponent >= 0 ? value * pow10_table[exponent] : value / pow10_table[-exponent];
+}
+
+/* [sign] digits [. digits] [e [sign] digits], like the subset of %f we need. */
+static bool parse_float(text_cursor_t *cur, float *out) {
+    skip_spaces(cur);
+    const uint8_t *p = cur->p;
+    const uint8_t *end = cur->end;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    uint32_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any_digits = false;
+    for (; p < end && is_digit(*p); ++p) {
+        any_digits = true;
+        if (digits < PARSE_MAX_DIGITS) {
+            mantissa = mantissa * 10u + (uint32_t)(*p - '0');
+            if (mantissa) {
+                digits++;
+            }
+        } else {
+            exponent++;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end && is_digit(*p); ++p) {
+            any_digits = true;
+            if (digits < PARSE_MAX_DIGITS) {
+                mantissa = mantissa * 10u + (uint32_t)(*p - '0');
+                if (mantissa) {
+                    digits++;
+                }
+                exponent--;
+            }
+        }
+    }
+    if (!any_digits) {
+        return false;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const uint8_t *q = p + 1;
+        bool exp_negative = false;
+        if (q < end && (*q == '-' || *q == '+')) {
+            exp_negative = *q == '-';
+            q++;
+        }
+        if (q < end && is_digit(*q)) {
+            int value = 0;
+            for (; q < end && is_digit(*q); ++q) {
+                if (value < 1000) {
+                    value = value * 10 + (*q - '0');
+                }
+            }
+            exponent += exp_negative ? -value : value;
+            p = q;
+        }
+    }
+
+    float value = 0.0f;
+    if (mantissa) {
+        if (exponent > PARSE_MAX_EXPONENT) {
+            exponent = PARSE_MAX_EXPONENT;
+        } else if (exponent < -PARSE_MAX_EXPONENT - PARSE_MAX_DIGITS) {
+            exponent = -PARSE_MAX_EXPONENT - PARSE_MAX_DIGITS;
+        }
+        value = scale_pow10((float)mantissa, exponent);
+    }
+    *out = negative ? -value : value;
+    cur->p = p;
+    return true;
+}
+
+/* Unsigned decimal, saturating at UINT32_MAX. */
+static bool parse_uint(text_cursor_t *cur, uint32_t *out) {
+    skip_spaces(cur);
+    const uint8_t *p = cur->p;
+    if (p < cur->end && *p == '+') {
+        p++;
+    }
+    if (p >= cur->end || !is_digit(*p)) {
+        return false;
+    }
+    uint32_t value = 0;
+    for (; p < cur->end && is_digit(*p); ++p) {
+        uint32_t digit = (uint32_t)(*p - '0');
+        value = value > (UINT32_MAX - digit) / 10u ? UINT32_MAX : value * 10u + digit;
+    }
+    *out = value;
+    cur->p = p;
+    return true;
+}
+
+static command_parse_result_t parse_value(text_cursor_t *cur, psl_command_t *command, uint8_t type) {
+    if (!parse_float(cur, &command->u.value)) {
+        return COMMAND_PARSE_UNRECOGNIZED;
+    }
+    command->type = type;
+    return COMMAND_PARSE_OK;
+}
+
+static command_parse_result_t parse_segment(text_cursor_t *cur, psl_command_t *command, uint8_t type) {
+    uint32_t index;
+    if (!parse_uint(cur, &index)) {
+        return COMMAND_PARSE_UNRECOGNIZED;
+    }
+    command->type = type;
+    command->u.index = index > 0 ? index - 1u : 0;
+    return COMMAND_PARSE_OK;
+}
+
+static command_parse_result_t parse_motion(text_cursor_t *cur, psl_command_t *command) {
+    if (!parse_float(cur, &command->u.motion.pitch) || !match_literal(cur, ",") ||
+        !parse_float(cur, &command->u.motion.roll) || !match_literal(cur, ",") ||
+        !parse_float(cur, &command->u.motion.yaw)) {
+        return COMMAND_PARSE_UNRECOGNIZED;
+    }
+    command->type = PSL_CMD_MOTION;
+    return COMMAND_PARSE_OK;
+}
+
+static bool parse_color_order(text_cursor_t *cur, uint8_t *order) {
+    skip_spaces(cur);
+    for (uint8_t i = 0; i < PIXEL_ORDER_COUNT; ++i) {
+        if (match_literal(cur, strip_config_order_name(i))) {
+            *order = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool command_parse_config(const uint8_t *data, size_t len, strip_config_t *config) {
+    text_cursor_t cur = {data, data + len};
+    memset(config, 0, sizeof(*config));
+    if (!match_literal(&cur, "CFG,") || !parse_color_order(&cur, &config->color_order)) {
+        return false;
+    }
+    while (match_literal(&cur, ",")) {
+        uint32_t pin;
+        uint32_t leds;
+        if (config->chain_count == WS2812_MAX_STRIPS || !parse_uint(&cur, &pin) || !match_literal(&cur, ":") ||
+            !parse_uint(&cur, &leds) || pin > UINT8_MAX || leds > UINT16_MAX) {
+            return false;
+        }
+        config->pins[config->chain_count] = (uint8_t)pin;
+        config->chain_leds[config->chain_count] = (uint16_t)leds;
+        config->chain_count++;
+    }
+    skip_spaces(&cur);
+    return cur.p == cur.end && config->chain_count > 0;
+}
+
+command_parse_result_t command_parse_text(const uint8_t *data, size_t len, psl_command_t *command) {
+    if (!data || len == 0) {
+        return COMMAND_PARSE_UNRECOGNIZED;
+    }
+    text_cursor_t cur = {data, data + len};
+    switch (data[0]) {
+    case 'H':
+        if (match_literal(&cur, "H,")) {
+            return parse_value(&cur, command, PSL_CMD_ADJUST_HUE);
+        }
+        if (match_literal(&cur, "H_SET,")) {
+            return parse_value(&cur, command, PSL_CMD_SET_HUE);
+        }
+        return COMMAND_PARSE_UNRECOGNIZED;
+    case 'B':
+        if (match_literal(&cur, "B,")) {
+            return parse_value(&cur, command, PSL_CMD_ADJUST_BRIGHTNESS);
+        }
+        if (match_literal(&cur, "B_SET,")) {
+            return parse_value(&cur, command, PSL_CMD_SET_BRIGHTNESS);
+        }
+        return COMMAND_PARSE_UNRECOGNIZED;
+    case 'S':
+        if (match_literal(&cur, "SEG_START,")) {
+            return parse_segment(&cur, command, PSL_CMD_SEGMENT_START);
+        }
+        if (match_literal(&cur, "SEG_END,")) {
+            return parse_segment(&cur, command, PSL_CMD_SEGMENT_END);
+        }
+        return COMMAND_PARSE_UNRECOGNIZED;
+    case 'R':
+        return match_literal(&cur, "RESET") ? COMMAND_PARSE_RESET : COMMAND_PARSE_UNRECOGNIZED;
+    case 'C':
+        return match_literal(&cur, "CFG,") ? COMMAND_PARSE_CONFIG : COMMAND_PARSE_UNRECOGNIZED;
+    default:
+        return parse_motion(&cur, command);
+    }
+}
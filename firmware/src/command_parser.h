@@ -0,0 +1,34 @@
+#ifndef COMMAND_PARSER_H
+#define COMMAND_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "command_queue.h"
+#include "strip_config.h"
+
+/*
+ * One-pass decoder for the ASCII command packets:
+ *
+ *   "H_SET,<deg>"  "B_SET,<pct>"  "H,<delta>"  "B,<delta>"
+ *   "SEG_START,<n>"  "SEG_END,<n>" (1-based)  "RESET"
+ *   "<pitch>,<roll>,<yaw>"
+ *   "CFG,<order>,<pin>:<leds>[,<pin>:<leds>...]"  e.g. "CFG,GRB,2:150,3:150"
+ *
+ * Dispatches on the first byte and parses numbers by hand, straight from the
+ * ATT buffer: no copy, no NUL terminator, no scanf.
+ */
+
+typedef enum {
+    COMMAND_PARSE_OK = 0,
+    COMMAND_PARSE_RESET,
+    COMMAND_PARSE_CONFIG, /* decode with command_parse_config() */
+    COMMAND_PARSE_UNRECOGNIZED
+} command_parse_result_t;
+
+command_parse_result_t command_parse_text(const uint8_t *data, size_t len, psl_command_t *command);
+
+/* A CFG packet: colour order, then one pin:leds pair per chain in strip
+ * order. Only checks the syntax; see strip_config_validate(). */
+bool command_parse_config(const uint8_t *data, size_t len, strip_config_t *config);
+
+#endif
@@ -0,0 +1,58 @@
+#include "command_queue.h"
+
+#include <string.h>
+
+_Static_assert((COMMAND_QUEUE_CAPACITY & (COMMAND_QUEUE_CAPACITY - 1u)) == 0,
+               "COMMAND_QUEUE_CAPACITY must be a power of two");
+
+void command_queue_init(command_queue_t *queue) {
+    memset(queue, 0, sizeof(*queue));
+}
+
+bool command_queue_stage(command_queue_t *queue, const psl_command_t *command) {
+    uint32_t staged = queue->staged;
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    if (staged - tail >= COMMAND_QUEUE_CAPACITY) {
+        return false;
+    }
+    queue->slots[staged & (COMMAND_QUEUE_CAPACITY - 1u)] = *command;
+    queue->staged = staged + 1u;
+    return true;
+}
+
+void command_queue_publish(command_queue_t *queue) {
+    __atomic_store_n(&queue->head, queue->staged, __ATOMIC_RELEASE);
+}
+
+void command_queue_discard_staged(command_queue_t *queue) {
+    if (queue->staged != queue->head) {
+        queue->staged = queue->head;
+        queue->dropped++;
+    }
+}
+
+bool command_queue_push(command_queue_t *queue, const psl_command_t *command) {
+    if (!command_queue_stage(queue, command)) {
+        queue->dropped++;
+        return false;
+    }
+    command_queue_publish(queue);
+    return true;
+}
+
+bool command_queue_pop(command_queue_t *queue, psl_command_t *command) {
+    uint32_t tail = queue->tail;
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return false;
+    }
+    *command = queue->slots[tail & (COMMAND_QUEUE_CAPACITY - 1u)];
+    __atomic_store_n(&queue->tail, tail + 1u, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint32_t command_queue_depth(const command_queue_t *queue) {
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    return head - tail;
+}
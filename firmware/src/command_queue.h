@@ -0,0 +1,67 @@
+#ifndef COMMAND_QUEUE_H
+#define COMMAND_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "frame_protocol.h"
+
+/*
+ * Decoded lighting commands and a lock-free single-producer/single-consumer
+ * ring to carry them from the BTstack core to the render core. The producer
+ * only writes head, the consumer only writes tail.
+ *
+ * A multi-command packet (one frame's runs plus its commit) is staged first
+ * and published with a single head store, so the consumer never sees half a
+ * frame.
+ */
+
+typedef enum {
+    PSL_CMD_SET_HUE = 0,
+    PSL_CMD_SET_BRIGHTNESS,
+    PSL_CMD_ADJUST_HUE,
+    PSL_CMD_ADJUST_BRIGHTNESS,
+    PSL_CMD_SEGMENT_START,
+    PSL_CMD_SEGMENT_END,
+    PSL_CMD_MOTION,
+    PSL_CMD_FRAME_RUN,
+    PSL_CMD_FRAME_PIXELS,
+    PSL_CMD_FRAME_COMMIT
+} psl_command_type_t;
+
+typedef struct {
+    uint8_t type;
+    union {
+        float value;
+        uint32_t index;
+        struct {
+            float pitch;
+            float roll;
+            float yaw;
+        } motion;
+        frame_run_t run;
+        frame_pixels_t pixels; /* rgb points into a renderer upload buffer */
+    } u;
+} psl_command_t;
+
+/* Room for a maximal 0xA0 frame: 255 runs plus its commit. */
+#define COMMAND_QUEUE_CAPACITY 256u
+
+typedef struct {
+    psl_command_t slots[COMMAND_QUEUE_CAPACITY];
+    uint32_t head;
+    uint32_t staged; /* producer-private, head <= staged */
+    uint32_t tail;
+    uint32_t dropped;
+} command_queue_t;
+
+void command_queue_init(command_queue_t *queue);
+bool command_queue_push(command_queue_t *queue, const psl_command_t *command);
+/* Stage without publishing; returns false (and stages nothing) when full. */
+bool command_queue_stage(command_queue_t *queue, const psl_command_t *command);
+void command_queue_publish(command_queue_t *queue);
+/* Drop everything staged since the last publish, counting it as one drop. */
+void command_queue_discard_staged(command_queue_t *queue);
+bool command_queue_pop(command_queue_t *queue, psl_command_t *command);
+uint32_t command_queue_depth(const command_queue_t *queue);
+
+#endif
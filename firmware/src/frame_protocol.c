@@ -0,0 +1,185 @@
+#include "frame_protocol.h"
+
+#include <string.h>
+
+frame_parse_status_t frame_reader_init(frame_reader_t *reader, const uint8_t *data, size_t len) {
+    reader->cursor = data;
+    reader->end = data;
+    reader->runs_left = 0;
+    reader->truncated = false;
+    if (!data || len < PSL_FRAME_HEADER_LEN || data[0] != PSL_FRAME_COMMAND_ID) {
+        return FRAME_PARSE_NOT_FRAME;
+    }
+    if (data[1] != PSL_FRAME_VERSION) {
+        return FRAME_PARSE_BAD_VERSION;
+    }
+    reader->cursor = data + PSL_FRAME_HEADER_LEN;
+    reader->end = data + len;
+    reader->runs_left = data[2];
+    return FRAME_PARSE_OK;
+}
+
+bool frame_reader_next(frame_reader_t *reader, frame_run_t *run) {
+    if (reader->runs_left == 0) {
+        return false;
+    }
+    if ((size_t)(reader->end - reader->cursor) < PSL_FRAME_RUN_LEN) {
+        reader->truncated = true;
+        reader->runs_left = 0;
+        return false;
+    }
+    const uint8_t *p = reader->cursor;
+    run->start = (uint16_t)(p[0] | (p[1] << 8));
+    run->length = (uint16_t)(p[2] | (p[3] << 8));
+    run->color.r = p[4];
+    run->color.g = p[5];
+    run->color.b = p[6];
+    reader->cursor = p + PSL_FRAME_RUN_LEN;
+    reader->runs_left--;
+    return true;
+}
+
+void frame_base_begin(frame_base_t *base) {
+    base->run_count = 0;
+    base->delta_seq = 0;
+    base->valid = true;
+}
+
+void frame_base_append(frame_base_t *base, const frame_run_t *run) {
+    if (base->run_count < PSL_FRAME_MAX_RUNS) {
+        base->runs[base->run_count++] = *run;
+    }
+}
+
+static inline uint8_t delta_bits(const uint8_t *bitmap, size_t bitmap_len, uint32_t bit) {
+    uint32_t byte = bit >> 3;
+    uint32_t value = bitmap[byte];
+    if (byte + 1u < bitmap_len) {
+        value |= (uint32_t)bitmap[byte + 1u] << 8;
+    }
+    return (uint8_t)((value >> (bit & 7u)) & 0x7u);
+}
+
+static uint32_t popcount8(uint8_t value) {
+    value = (uint8_t)(value - ((value >> 1) & 0x55u));
+    value = (uint8_t)((value & 0x33u) + ((value >> 2) & 0x33u));
+    return (uint32_t)((value + (value >> 4)) & 0x0Fu);
+}
+
+frame_parse_status_t frame_delta_reader_init(frame_delta_reader_t *reader, frame_base_t *base,
+                                             const uint8_t *data, size_t len) {
+    reader->base = base;
+    reader->bitmap = NULL;
+    reader->deltas = NULL;
+    reader->index = 0;
+    if (!data || len < 1 || data[0] != PSL_FRAME_DELTA_COMMAND_ID) {
+        return FRAME_PARSE_NOT_FRAME;
+    }
+    if (len < PSL_FRAME_DELTA_HEADER_LEN) {
+        return FRAME_PARSE_TRUNCATED;
+    }
+    if (data[1] != PSL_FRAME_VERSION) {
+        return FRAME_PARSE_BAD_VERSION;
+    }
+    const uint8_t seq = data[2];
+    const uint8_t run_count = data[3];
+    if (!base->valid || run_count != base->run_count) {
+        return FRAME_PARSE_NO_BASE;
+    }
+    if (seq != (uint8_t)(base->delta_seq + 1u)) {
+        return FRAME_PARSE_OUT_OF_SEQUENCE;
+    }
+
+    const uint32_t bits = (uint32_t)run_count * 3u;
+    const size_t bitmap_len = (bits + 7u) / 8u;
+    if (len < PSL_FRAME_DELTA_HEADER_LEN + bitmap_len) {
+        return FRAME_PARSE_TRUNCATED;
+    }
+    const uint8_t *bitmap = data + PSL_FRAME_DELTA_HEADER_LEN;
+    size_t delta_count = 0;
+    for (size_t i = 0; i < bitmap_len; ++i) {
+        uint8_t byte = bitmap[i];
+        if (i == bitmap_len - 1u && (bits & 7u)) {
+            byte &= (uint8_t)((1u << (bits & 7u)) - 1u);
+        }
+        delta_count += popcount8(byte);
+    }
+    if (len < PSL_FRAME_DELTA_HEADER_LEN + bitmap_len + delta_count) {
+        return FRAME_PARSE_TRUNCATED;
+    }
+
+    reader->bitmap = bitmap;
+    reader->deltas = bitmap + bitmap_len;
+    base->delta_seq = seq;
+    return FRAME_PARSE_OK;
+}
+
+bool frame_delta_reader_next(frame_delta_reader_t *reader, frame_run_t *run) {
+    frame_base_t *base = reader->base;
+    const size_t bitmap_len = ((size_t)base->run_count * 3u + 7u) / 8u;
+    while (reader->index < base->run_count) {
+        const uint16_t index = reader->index++;
+        const uint8_t mask = delta_bits(reader->bitmap, bitmap_len, (uint32_t)index * 3u);
+        if (!mask) {
+            continue;
+        }
+        frame_run_t *target = &base->runs[index];
+        if (mask & 0x1u) {
+            target->color.r = (uint8_t)(target->color.r + *reader->deltas++);
+        }
+        if (mask & 0x2u) {
+            target->color.g = (uint8_t)(target->color.g + *reader->deltas++);
+        }
+        if (mask & 0x4u) {
+            target->color.b = (uint8_t)(target->color.b + *reader->deltas++);
+        }
+        *run = *target;
+        return true;
+    }
+    return false;
+}
+
+frame_parse_status_t frame_pixels_parse(const uint8_t *data, size_t len, frame_pixels_t *frame) {
+    if (!data || len < 1 || data[0] != PSL_FRAME_PIXELS_COMMAND_ID) {
+        return FRAME_PARSE_NOT_FRAME;
+    }
+    if (len < PSL_FRAME_PIXELS_HEADER_LEN) {
+        return FRAME_PARSE_TRUNCATED;
+    }
+    if (data[1] != PSL_FRAME_VERSION) {
+        return FRAME_PARSE_BAD_VERSION;
+    }
+    frame->start = (uint16_t)(data[2] | (data[3] << 8));
+    frame->count = (uint16_t)(data[4] | (data[5] << 8));
+    frame->rgb = data + PSL_FRAME_PIXELS_HEADER_LEN;
+    if ((len - PSL_FRAME_PIXELS_HEADER_LEN) / 3u < frame->count) {
+        return FRAME_PARSE_TRUNCATED;
+    }
+    return FRAME_PARSE_OK;
+}
+
+void frame_apply_pixels(color_rgb_t *pixels, uint16_t pixel_count, uint16_t start,
+                        const uint8_t *rgb, uint16_t count) {
+    if (start >= pixel_count) {
+        return;
+    }
+    if (count > pixel_count - start) {
+        count = (uint16_t)(pixel_count - start);
+    }
+    _Static_assert(sizeof(color_rgb_t) == 3, "color_rgb_t must be packed RGB");
+    memcpy(&pixels[start], rgb, (size_t)count * 3u);
+}
+
+void frame_apply_run(color_rgb_t *pixels, uint16_t pixel_count, const frame_run_t *run) {
+    if (run->start >= pixel_count || run->length == 0) {
+        return;
+    }
+    uint32_t end = (uint32_t)run->start + run->length;
+    if (end > pixel_count) {
+        end = pixel_count;
+    }
+    const color_rgb_t color = run->color;
+    for (uint32_t i = run->start; i < end; ++i) {
+        pixels[i] = color;
+    }
+}
@@ -0,0 +1,123 @@
+#ifndef FRAME_PROTOCOL_H
+#define FRAME_PROTOCOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "color.h"
+
+/*
+ * Binary run-length frame (command 0xA0), as sent by the iOS app's
+ * LEDFrame.dataPayload():
+ *
+ *   [0xA0][version = 1][run_count]
+ *   run_count x [start u16 LE][length u16 LE][r][g][b]
+ *
+ * The reader walks runs in place in the caller's buffer; nothing is copied.
+ *
+ * Delta frame (command 0xA3) against the last committed frame's run list:
+ *
+ *   [0xA3][version = 1][seq][run_count]
+ *   [change bitmap: 3 bits per run (r, g, b), LSB first, ceil(run_count * 3 / 8) bytes]
+ *   one delta byte per set bit, in run then r/g/b order, added mod 256
+ *
+ * Run geometry is inherited from the base frame, unchanged runs and channels
+ * cost nothing. A full frame resets seq to 0; each delta must carry the
+ * previous seq + 1 (mod 256), otherwise it is rejected until the next full
+ * frame.
+ *
+ * Pixel frame (command 0xA5), one colour per LED:
+ *
+ *   [0xA5][version = 1][start u16 LE][count u16 LE] count x [r][g][b]
+ *
+ * A full strip is ~900 bytes, so it normally arrives in fragments (0xA4,
+ * see frame_reassembly.h).
+ */
+
+#define PSL_FRAME_COMMAND_ID 0xA0
+#define PSL_FRAME_VERSION 1
+#define PSL_FRAME_HEADER_LEN 3u
+#define PSL_FRAME_RUN_LEN 7u
+#define PSL_FRAME_MAX_RUNS 255u
+
+#define PSL_FRAME_DELTA_COMMAND_ID 0xA3
+#define PSL_FRAME_DELTA_HEADER_LEN 4u
+
+#define PSL_FRAME_PIXELS_COMMAND_ID 0xA5
+#define PSL_FRAME_PIXELS_HEADER_LEN 6u
+
+typedef struct {
+    uint16_t start;
+    uint16_t length;
+    color_rgb_t color;
+} frame_run_t;
+
+typedef enum {
+    FRAME_PARSE_OK = 0,
+    FRAME_PARSE_NOT_FRAME,
+    FRAME_PARSE_BAD_VERSION,
+    FRAME_PARSE_TRUNCATED,
+    FRAME_PARSE_NO_BASE,
+    FRAME_PARSE_OUT_OF_SEQUENCE
+} frame_parse_status_t;
+
+typedef struct {
+    const uint8_t *cursor;
+    const uint8_t *end;
+    uint8_t runs_left;
+    bool truncated;
+} frame_reader_t;
+
+frame_parse_status_t frame_reader_init(frame_reader_t *reader, const uint8_t *data, size_t len);
+
+/* Returns false once all runs are read or the buffer ends mid-run; the
+ * latter sets reader->truncated. */
+bool frame_reader_next(frame_reader_t *reader, frame_run_t *run);
+
+/* Run list of the last committed frame, the reference for delta frames. */
+typedef struct {
+    frame_run_t runs[PSL_FRAME_MAX_RUNS];
+    uint8_t run_count;
+    uint8_t delta_seq;
+    bool valid;
+} frame_base_t;
+
+/* Start recording a full frame; append each of its runs as it is decoded. */
+void frame_base_begin(frame_base_t *base);
+void frame_base_append(frame_base_t *base, const frame_run_t *run);
+
+typedef struct {
+    frame_base_t *base;
+    const uint8_t *bitmap;
+    const uint8_t *deltas;
+    uint16_t index;
+} frame_delta_reader_t;
+
+/*
+ * Validates the whole delta (length, base, sequence) up front, so once this
+ * returns FRAME_PARSE_OK every changed run can be read and the base has
+ * already advanced to the new seq.
+ */
+frame_parse_status_t frame_delta_reader_init(frame_delta_reader_t *reader, frame_base_t *base,
+                                             const uint8_t *data, size_t len);
+
+/* Applies the next changed run's delta to the base and returns the run. */
+bool frame_delta_reader_next(frame_delta_reader_t *reader, frame_run_t *run);
+
+typedef struct {
+    uint16_t start;
+    uint16_t count;
+    const uint8_t *rgb;
+} frame_pixels_t;
+
+/* TRUNCATED if fewer than count pixels follow the header. */
+frame_parse_status_t frame_pixels_parse(const uint8_t *data, size_t len, frame_pixels_t *frame);
+
+/* Copy packed RGB pixels, clipped to [0, pixel_count). */
+void frame_apply_pixels(color_rgb_t *pixels, uint16_t pixel_count, uint16_t start,
+                        const uint8_t *rgb, uint16_t count);
+
+/* Paint a run, clipped to [0, pixel_count). */
+void frame_apply_run(color_rgb_t *pixels, uint16_t pixel_count, const frame_run_t *run);
+
+#endif
@@ -0,0 +1,72 @@
+#include "frame_reassembly.h"
+
+#include <string.h>
+
+fragment_parse_status_t frame_fragment_parse(const uint8_t *data, size_t len, frame_fragment_t *fragment) {
+    if (!data || len < 1 || data[0] != PSL_FRAGMENT_COMMAND_ID) {
+        return FRAGMENT_PARSE_NOT_FRAGMENT;
+    }
+    if (len < PSL_FRAGMENT_HEADER_LEN || data[3] == 0 || data[2] >= data[3]) {
+        return FRAGMENT_PARSE_INVALID;
+    }
+    fragment->frame_id = data[1];
+    fragment->index = data[2];
+    fragment->count = data[3];
+    fragment->flags = data[4];
+    fragment->payload = data + PSL_FRAGMENT_HEADER_LEN;
+    fragment->payload_len = len - PSL_FRAGMENT_HEADER_LEN;
+    return FRAGMENT_PARSE_OK;
+}
+
+void frame_reassembly_set_buffer(frame_reassembly_t *reassembly, uint8_t *buffer, size_t capacity) {
+    frame_reassembly_abort(reassembly);
+    reassembly->buffer = buffer;
+    reassembly->capacity = buffer ? capacity : 0;
+}
+
+void frame_reassembly_abort(frame_reassembly_t *reassembly) {
+    if (reassembly->active) {
+        reassembly->active = false;
+        reassembly->dropped++;
+    }
+}
+
+static reassembly_status_t reject(frame_reassembly_t *reassembly) {
+    frame_reassembly_abort(reassembly);
+    return REASSEMBLY_REJECTED;
+}
+
+reassembly_status_t frame_reassembly_add(frame_reassembly_t *reassembly, const frame_fragment_t *fragment) {
+    if (fragment->index == 0) {
+        frame_reassembly_abort(reassembly);
+        reassembly->active = true;
+        reassembly->frame_id = fragment->frame_id;
+        reassembly->count = fragment->count;
+        reassembly->next_index = 0;
+        reassembly->len = 0;
+    } else if (!reassembly->active) {
+        return REASSEMBLY_REJECTED;
+    } else if (fragment->frame_id != reassembly->frame_id || fragment->count != reassembly->count ||
+               fragment->index != reassembly->next_index) {
+        return reject(reassembly);
+    }
+
+    if (fragment->payload_len > reassembly->capacity - reassembly->len) {
+        return reject(reassembly);
+    }
+    memcpy(reassembly->buffer + reassembly->len, fragment->payload, fragment->payload_len);
+    reassembly->len += fragment->payload_len;
+    reassembly->next_index++;
+
+    const bool last = reassembly->next_index == reassembly->count;
+    const bool final = (fragment->flags & PSL_FRAGMENT_FLAG_FINAL) != 0;
+    if (last != final) {
+        return reject(reassembly);
+    }
+    if (!last) {
+        return REASSEMBLY_PENDING;
+    }
+    reassembly->active = false;
+    reassembly->completed++;
+    return REASSEMBLY_COMPLETE;
+}
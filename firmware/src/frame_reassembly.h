@@ -0,0 +1,71 @@
+#ifndef FRAME_REASSEMBLY_H
+#define FRAME_REASSEMBLY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Fragment (command 0xA4) carrying a slice of a larger packet:
+ *
+ *   [0xA4][frame_id][index][count][flags] payload...
+ *
+ * Fragments of one frame share frame_id and arrive in index order (ATT
+ * writes on a link are ordered); the last one has index == count - 1 and
+ * PSL_FRAGMENT_FLAG_FINAL set. The reassembled payload is an ordinary
+ * packet (0xA0, 0xA5, ...) and is dispatched as if written in one go.
+ *
+ * A gap, a foreign frame_id or an overflow abandons the frame; a fragment 0
+ * always starts a new one. Timeouts are the caller's job via
+ * frame_reassembly_abort().
+ */
+
+#define PSL_FRAGMENT_COMMAND_ID 0xA4
+#define PSL_FRAGMENT_HEADER_LEN 5u
+#define PSL_FRAGMENT_FLAG_FINAL 0x01u
+
+typedef struct {
+    uint8_t frame_id;
+    uint8_t index;
+    uint8_t count;
+    uint8_t flags;
+    const uint8_t *payload;
+    size_t payload_len;
+} frame_fragment_t;
+
+typedef enum {
+    FRAGMENT_PARSE_OK = 0,
+    FRAGMENT_PARSE_NOT_FRAGMENT,
+    FRAGMENT_PARSE_INVALID
+} fragment_parse_status_t;
+
+fragment_parse_status_t frame_fragment_parse(const uint8_t *data, size_t len, frame_fragment_t *fragment);
+
+typedef enum {
+    REASSEMBLY_PENDING = 0,
+    REASSEMBLY_COMPLETE,
+    REASSEMBLY_REJECTED
+} reassembly_status_t;
+
+typedef struct {
+    uint8_t *buffer;
+    size_t capacity;
+    size_t len;
+    uint8_t frame_id;
+    uint8_t next_index;
+    uint8_t count;
+    bool active;
+    uint32_t completed;
+    uint32_t dropped;
+} frame_reassembly_t;
+
+/* The buffer is only written, never freed; swap it out between frames. */
+void frame_reassembly_set_buffer(frame_reassembly_t *reassembly, uint8_t *buffer, size_t capacity);
+
+/* On REASSEMBLY_COMPLETE, buffer[0..len) holds the whole payload. */
+reassembly_status_t frame_reassembly_add(frame_reassembly_t *reassembly, const frame_fragment_t *fragment);
+
+/* Drop a partially received frame, e.g. when its timeout fires. */
+void frame_reassembly_abort(frame_reassembly_t *reassembly);
+
+#endif
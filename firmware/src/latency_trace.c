@@ -0,0 +1,202 @@
+#include "latency_trace.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "pico/stdlib.h"
+
+_Static_assert((LATENCY_TRACE_RECORDS & (LATENCY_TRACE_RECORDS - 1u)) == 0,
+               "LATENCY_TRACE_RECORDS must be a power of two");
+
+enum {
+    TRACE_ATT = 0,
+    TRACE_DECODED,
+    TRACE_RENDER,
+    TRACE_OUTPUT,
+    TRACE_WIRE,
+    TRACE_POINTS
+};
+
+typedef struct {
+    uint32_t us[TRACE_POINTS];
+} trace_record_t;
+
+typedef struct {
+    const char *name;
+    uint8_t from;
+    uint8_t to;
+} trace_stage_t;
+
+static const trace_stage_t trace_stages[] = {
+    {"att->decoded", TRACE_ATT, TRACE_DECODED},
+    {"decoded->render", TRACE_DECODED, TRACE_RENDER},
+    {"render->dma", TRACE_RENDER, TRACE_OUTPUT},
+    {"dma->wire", TRACE_OUTPUT, TRACE_WIRE},
+    {"att->wire", TRACE_ATT, TRACE_WIRE},
+};
+
+/* log2 buckets: <16 us, <32 us, ... , >= 64 ms. */
+#define TRACE_HISTOGRAM_FIRST_SHIFT 4u
+#define TRACE_HISTOGRAM_BUCKETS 14u
+
+/* Core0: the write currently being decoded. */
+static uint32_t write_start_us;
+static bool write_open = false;
+
+/* Core0 -> core1 hand-off, single slot. */
+static trace_record_t mailbox;
+static uint32_t mailbox_full = 0;
+
+/* Core1 pipeline; each stage holds at most one record. */
+static trace_record_t rendering;
+static bool rendering_valid = false;
+static bool rendering_stamped = false;
+static trace_record_t committed;
+static bool committed_valid = false;
+static trace_record_t in_flight;
+static bool in_flight_valid = false;
+
+/* Completed records, written by core1 only. */
+static trace_record_t records[LATENCY_TRACE_RECORDS];
+static uint32_t records_head = 0;
+
+static uint32_t dump_scratch[LATENCY_TRACE_RECORDS];
+
+void latency_trace_write_begin(void) {
+    write_start_us = time_us_32();
+    write_open = true;
+}
+
+void latency_trace_write_decoded(void) {
+    if (!write_open) {
+        return;
+    }
+    write_open = false;
+    if (__atomic_load_n(&mailbox_full, __ATOMIC_ACQUIRE)) {
+        /* Core1 hasn't picked up an older write yet; keep tracing that one. */
+        return;
+    }
+    mailbox.us[TRACE_ATT] = write_start_us;
+    mailbox.us[TRACE_DECODED] = time_us_32();
+    __atomic_store_n(&mailbox_full, 1u, __ATOMIC_RELEASE);
+}
+
+void latency_trace_claim_write(void) {
+    if (rendering_valid || !__atomic_load_n(&mailbox_full, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    rendering = mailbox;
+    rendering_valid = true;
+    rendering_stamped = false;
+    __atomic_store_n(&mailbox_full, 0u, __ATOMIC_RELEASE);
+}
+
+void latency_trace_render_begin(void) {
+    if (rendering_valid && !rendering_stamped) {
+        rendering.us[TRACE_RENDER] = time_us_32();
+        rendering_stamped = true;
+    }
+}
+
+void latency_trace_frame_committed(void) {
+    if (!rendering_valid || !rendering_stamped) {
+        return;
+    }
+    /* A withdrawn frame's write is shown by this one; the older record wins. */
+    if (!committed_valid) {
+        committed = rendering;
+        committed_valid = true;
+    }
+    rendering_valid = false;
+}
+
+void latency_trace_frame_unchanged(void) {
+    rendering_valid = false;
+}
+
+void latency_trace_frame_started(void) {
+    if (!committed_valid) {
+        return;
+    }
+    in_flight = committed;
+    in_flight.us[TRACE_OUTPUT] = time_us_32();
+    in_flight_valid = true;
+    committed_valid = false;
+}
+
+void latency_trace_frame_on_wire(uint32_t wire_us) {
+    if (!in_flight_valid) {
+        return;
+    }
+    in_flight.us[TRACE_WIRE] = wire_us;
+    uint32_t head = records_head;
+    records[head & (LATENCY_TRACE_RECORDS - 1u)] = in_flight;
+    __atomic_store_n(&records_head, head + 1u, __ATOMIC_RELEASE);
+    in_flight_valid = false;
+}
+
+static void sort_u32(uint32_t *values, uint32_t count) {
+    for (uint32_t i = 1; i < count; ++i) {
+        uint32_t value = values[i];
+        uint32_t j = i;
+        while (j > 0 && values[j - 1u] > value) {
+            values[j] = values[j - 1u];
+            --j;
+        }
+        values[j] = value;
+    }
+}
+
+/* Nearest-rank percentile of a sorted, non-empty array. */
+static uint32_t percentile(const uint32_t *sorted, uint32_t count, uint32_t pct) {
+    uint32_t rank = (count * pct + 99u) / 100u;
+    return sorted[rank ? rank - 1u : 0];
+}
+
+static void print_histogram(const uint32_t *sorted, uint32_t count) {
+    uint32_t buckets[TRACE_HISTOGRAM_BUCKETS] = {0};
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t bucket = 0;
+        while (bucket + 1u < TRACE_HISTOGRAM_BUCKETS &&
+               sorted[i] >= (1u << (TRACE_HISTOGRAM_FIRST_SHIFT + bucket))) {
+            ++bucket;
+        }
+        buckets[bucket]++;
+    }
+    printf("   ");
+    for (uint32_t bucket = 0; bucket < TRACE_HISTOGRAM_BUCKETS; ++bucket) {
+        if (!buckets[bucket]) {
+            continue;
+        }
+        if (bucket + 1u < TRACE_HISTOGRAM_BUCKETS) {
+            printf(" <%luus:%lu", (unsigned long)(1u << (TRACE_HISTOGRAM_FIRST_SHIFT + bucket)),
+                   (unsigned long)buckets[bucket]);
+        } else {
+            printf(" >=%luus:%lu", (unsigned long)(1u << (TRACE_HISTOGRAM_FIRST_SHIFT + bucket - 1u)),
+                   (unsigned long)buckets[bucket]);
+        }
+    }
+    printf("\n");
+}
+
+void latency_trace_dump(void) {
+    uint32_t head = __atomic_load_n(&records_head, __ATOMIC_ACQUIRE);
+    /* Skip the oldest slot: it is the next one core1 overwrites. */
+    uint32_t count = head < LATENCY_TRACE_RECORDS - 1u ? head : LATENCY_TRACE_RECORDS - 1u;
+    printf("Latency trace: %lu writes (%lu total)\n", (unsigned long)count, (unsigned long)head);
+    if (count == 0) {
+        return;
+    }
+    for (size_t s = 0; s < sizeof(trace_stages) / sizeof(trace_stages[0]); ++s) {
+        const trace_stage_t *stage = &trace_stages[s];
+        for (uint32_t i = 0; i < count; ++i) {
+            const trace_record_t *record = &records[(head - count + i) & (LATENCY_TRACE_RECORDS - 1u)];
+            dump_scratch[i] = record->us[stage->to] - record->us[stage->from];
+        }
+        sort_u32(dump_scratch, count);
+        printf("  %-16s p50 %6lu us  p99 %6lu us  max %6lu us\n", stage->name,
+               (unsigned long)percentile(dump_scratch, count, 50u),
+               (unsigned long)percentile(dump_scratch, count, 99u),
+               (unsigned long)dump_scratch[count - 1u]);
+        print_histogram(dump_scratch, count);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <stdint.h>
+
+/*
+ * End-to-end latency trace, from a BLE write reaching the ATT callback to
+ * the last bit of the frame showing it leaving the PIO. Each traced write
+ * carries five timestamps (time_us_32, shared by both cores):
+ *
+ *   att      ATT write callback entry                     core0
+ *   decoded  commands published to the renderer queue     core0
+ *   render   core1 starts rendering the frame             core1
+ *   output   DMA starts clocking that frame to the PIO    core1 (IRQs off)
+ *   wire     PIO FIFO drained, last bit on the wire       core1 (latch alarm)
+ *
+ * Only one write is in flight per stage: when several writes coalesce into
+ * one frame, the oldest is traced, since it waited longest. Completed
+ * records go into a fixed ring of LATENCY_TRACE_RECORDS entries; every call
+ * is O(1) and lock-free so the hooks can sit in callbacks and IRQs.
+ */
+
+#define LATENCY_TRACE_RECORDS 256u
+
+/* Core0, BLE callbacks. */
+void latency_trace_write_begin(void);
+void latency_trace_write_decoded(void);
+
+/* Core1 renderer: claim before draining the queue, then mark the render. */
+void latency_trace_claim_write(void);
+void latency_trace_render_begin(void);
+
+/* Core1 output engine, called with interrupts disabled or from its IRQs. */
+void latency_trace_frame_committed(void);
+/* The frame matched the strip and was not sent; its write is dropped. */
+void latency_trace_frame_unchanged(void);
+void latency_trace_frame_started(void);
+void latency_trace_frame_on_wire(uint32_t wire_us);
+
+/* Print per-stage p50/p99/max and a log2 histogram over USB stdio. Core0,
+ * idle time only: it sorts the whole ring. */
+void latency_trace_dump(void);
+
+#endif
@@ -0,0 +1,96 @@
+#include "log_ring.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+_Static_assert((LOG_RING_CAPACITY & (LOG_RING_CAPACITY - 1u)) == 0,
+               "LOG_RING_CAPACITY must be a power of two");
+
+#define LOG_RING_CORES 2u
+
+typedef struct {
+    const char *fmt;
+    uint32_t timestamp_us;
+    uintptr_t args[LOG_RING_MAX_ARGS];
+    uint32_t seq; /* reservation index + 1 once the entry is complete */
+} log_entry_t;
+
+/*
+ * One ring per core, so producers never contend across cores. Within a
+ * core an IRQ may preempt a writer, so the slot is reserved with interrupts
+ * briefly masked (the M0+ has no exclusive load/store) and filled
+ * afterwards; the reader stops at the first slot whose seq isn't published.
+ */
+typedef struct {
+    log_entry_t entries[LOG_RING_CAPACITY];
+    uint32_t head;
+    uint32_t tail;
+    uint32_t overflow;
+    uint32_t overflow_reported;
+} log_ring_t;
+
+static log_ring_t rings[LOG_RING_CORES];
+
+void log_ring_write(const char *fmt, uintptr_t a, uintptr_t b, uintptr_t c, uintptr_t d) {
+    log_ring_t *ring = &rings[get_core_num()];
+    uint32_t irq_state = save_and_disable_interrupts();
+    uint32_t head = ring->head;
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= LOG_RING_CAPACITY) {
+        ring->overflow++;
+        restore_interrupts(irq_state);
+        return;
+    }
+    ring->head = head + 1u;
+    restore_interrupts(irq_state);
+
+    log_entry_t *entry = &ring->entries[head & (LOG_RING_CAPACITY - 1u)];
+    entry->fmt = fmt;
+    entry->timestamp_us = time_us_32();
+    entry->args[0] = a;
+    entry->args[1] = b;
+    entry->args[2] = c;
+    entry->args[3] = d;
+    __atomic_store_n(&entry->seq, head + 1u, __ATOMIC_RELEASE);
+}
+
+static bool log_ring_pop(log_ring_t *ring, log_entry_t *out) {
+    uint32_t tail = ring->tail;
+    const log_entry_t *entry = &ring->entries[tail & (LOG_RING_CAPACITY - 1u)];
+    if (__atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE) != tail + 1u) {
+        return false;
+    }
+    *out = *entry;
+    __atomic_store_n(&ring->tail, tail + 1u, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint32_t log_ring_drain(uint32_t max_entries) {
+    uint32_t printed = 0;
+    for (uint core = 0; core < LOG_RING_CORES; ++core) {
+        log_ring_t *ring = &rings[core];
+        log_entry_t entry;
+        while (printed < max_entries && log_ring_pop(ring, &entry)) {
+            printf("[%6lu.%03lu c%u] ", (unsigned long)(entry.timestamp_us / 1000000u),
+                   (unsigned long)((entry.timestamp_us / 1000u) % 1000u), core);
+            printf(entry.fmt, entry.args[0], entry.args[1], entry.args[2], entry.args[3]);
+            printed++;
+        }
+        uint32_t overflow = ring->overflow;
+        if (overflow != ring->overflow_reported) {
+            printf("log: %lu messages dropped on core%u\n",
+                   (unsigned long)(overflow - ring->overflow_reported), core);
+            ring->overflow_reported = overflow;
+        }
+    }
+    return printed;
+}
+
+uint32_t log_ring_overflow(void) {
+    uint32_t total = 0;
+    for (uint core = 0; core < LOG_RING_CORES; ++core) {
+        total += rings[core].overflow;
+    }
+    return total;
+}
@@ -0,0 +1,55 @@
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <stdint.h>
+
+/*
+ * Deferred binary logger. PSL_LOG_*() stores the format pointer, a
+ * timestamp and up to four integer arguments in a per-core ring in O(1),
+ * without formatting or touching stdio, so it is safe from BLE callbacks,
+ * IRQ handlers and core1. log_ring_drain() formats and prints from idle
+ * time on core0. When a ring is full new messages are dropped and counted.
+ *
+ * Formats must be string literals; arguments are integers (%u, %lu, %x,
+ * %d) or pointers to string literals (%s). Anything that may not outlive
+ * the call (packet buffers, stack strings) must not be passed.
+ *
+ * Messages above PSL_LOG_LEVEL compile to nothing.
+ */
+
+#define PSL_LOG_LEVEL_NONE 0
+#define PSL_LOG_LEVEL_ERROR 1
+#define PSL_LOG_LEVEL_WARN 2
+#define PSL_LOG_LEVEL_INFO 3
+#define PSL_LOG_LEVEL_DEBUG 4
+
+#ifndef PSL_LOG_LEVEL
+#define PSL_LOG_LEVEL PSL_LOG_LEVEL_INFO
+#endif
+
+#define LOG_RING_CAPACITY 128u
+#define LOG_RING_MAX_ARGS 4
+
+void log_ring_write(const char *fmt, uintptr_t a, uintptr_t b, uintptr_t c, uintptr_t d);
+
+/* Print up to max_entries queued messages; returns how many were printed. */
+uint32_t log_ring_drain(uint32_t max_entries);
+
+/* Messages dropped because a ring was full, both cores. */
+uint32_t log_ring_overflow(void);
+
+#define PSL_LOG_PAD_(fmt, a, b, c, d, ...) \
+    (fmt), (uintptr_t)(a), (uintptr_t)(b), (uintptr_t)(c), (uintptr_t)(d)
+#define PSL_LOG_(level, ...)                                             \
+    do {                                                                 \
+        if ((level) <= PSL_LOG_LEVEL) {                                  \
+            log_ring_write(PSL_LOG_PAD_(__VA_ARGS__, 0, 0, 0, 0, 0));    \
+        }                                                                \
+    } while (0)
+
+#define PSL_LOG_ERROR(...) PSL_LOG_(PSL_LOG_LEVEL_ERROR, __VA_ARGS__)
+#define PSL_LOG_WARN(...) PSL_LOG_(PSL_LOG_LEVEL_WARN, __VA_ARGS__)
+#define PSL_LOG_INFO(...) PSL_LOG_(PSL_LOG_LEVEL_INFO, __VA_ARGS__)
+#define PSL_LOG_DEBUG(...) PSL_LOG_(PSL_LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+#endif
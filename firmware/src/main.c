@@ -3,7 +3,6 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
-#include <math.h>
 #include "pico/stdlib.h"
 #include "pico/stdio_usb.h"
 #include "pico/rand.h"
@@ -23,19 +22,32 @@
 #include "ble/att_server.h"
 #include "psl_motion_gatt.h"
 
-#include "ws2812.pio.h"
+#include "bench.h"
+#include "latency_trace.h"
+#include "log_ring.h"
+#include "ble_link.h"
+#include "command_parser.h"
+#include "frame_protocol.h"
+#include "frame_reassembly.h"
+#include "motion_protocol.h"
+#include "renderer.h"
+#include "strip_config.h"
+#include "telemetry.h"
 
-#define LED_PIN 0
-#define NUM_LEDS 300
-#define PACKET_BUFFER 128
 #define BLE_DEVICE_NAME "PSL Motion"
 #define BLE_DEVICE_NAME_LEN (sizeof(BLE_DEVICE_NAME) - 1)
 #define MAX_DEVICE_NAME_LEN (BLE_DEVICE_NAME_LEN + 5)
 #define PSL_SHORT_NAME "PSL Mtn"
 
-#define MIN_BRIGHTNESS_NORMALIZED 0.05f
-#define MAX_BRIGHTNESS_NORMALIZED 1.0f
 #define STARTUP_LOG_WAIT_MS 1000
+#define RENDER_STATS_PERIOD_MS 5000u
+/* An incomplete fragmented frame is discarded after this long without a fragment. */
+#define REASSEMBLY_TIMEOUT_MS 250u
+/* Idle loop: print at most this many queued log lines per pass. */
+#define LOG_DRAIN_BATCH 16u
+#define LOG_IDLE_SLEEP_MS 2u
+/* Typed on the USB console to print the latency trace. */
+#define CONSOLE_LATENCY_DUMP 'l'
 
 static const uint8_t PSL_BLE_SERVICE_UUID[16] = {
     0x21, 0x43, 0x65, 0x87, 0xa9, 0xcb, 0xed, 0x0f,
@@ -43,6 +55,10 @@ static const uint8_t PSL_BLE_SERVICE_UUID[16] = {
 };
 static const uint16_t ble_command_value_handle =
     ATT_CHARACTERISTIC_0C1D2E3F_4051_6273_8495_A6B7C8D9EAFB_01_VALUE_HANDLE;
+static const uint16_t ble_telemetry_value_handle =
+    ATT_CHARACTERISTIC_0C1D2E3F_4051_6273_8495_A6B7C8D9EAFC_01_VALUE_HANDLE;
+static const uint16_t ble_telemetry_config_handle =
+    ATT_CHARACTERISTIC_0C1D2E3F_4051_6273_8495_A6B7C8D9EAFC_01_CLIENT_CONFIGURATION_HANDLE;
 
 enum {
     PSL_SHORT_NAME_LEN = sizeof(PSL_SHORT_NAME) - 1,
@@ -60,14 +76,18 @@ static uint8_t device_name_len = BLE_DEVICE_NAME_LEN;
 static bool advertising_active = false;
 static btstack_packet_callback_registration_t btstack_event_cb;
 
-static uint16_t segment_start = 0;
-static uint16_t segment_end = NUM_LEDS - 1;
-
-static void render_color_from_state(void);
-
-static PIO led_pio = pio0;
-static uint led_sm = 0;
-static uint led_offset = 0;
+static btstack_timer_source_t render_stats_timer;
+static render_stats_t render_stats_reported;
+static motion_stream_stats_t motion_stats;
+static motion_stream_stats_t motion_stats_reported;
+/* Base for 0xA3 deltas; invalid once a state command takes core1 out of frame mode. */
+static frame_base_t frame_base;
+static uint32_t frame_delta_rejected;
+static uint32_t frame_delta_rejected_reported;
+static frame_reassembly_t reassembly;
+static btstack_timer_source_t reassembly_timer;
+static uint32_t reassembly_dropped_reported;
+static uint32_t upload_unavailable;
 
 static void copy_uuid_le(uint8_t *dest, const uint8_t *uuid) {
     for (size_t i = 0; i < sizeof(PSL_BLE_SERVICE_UUID); ++i) {
@@ -86,16 +106,6 @@ static void wait_for_usb_logger(void) {
 #endif
 }
 
-static inline float clampf(float value, float min, float max) {
-    if (value < min) {
-        return min;
-    }
-    if (value > max) {
-        return max;
-    }
-    return value;
-}
-
 static void configure_random_address(void) {
     bd_addr_t addr;
     for (size_t i = 0; i < sizeof(addr); ++i) {
@@ -103,8 +113,9 @@ static void configure_random_address(void) {
     }
     addr[5] = (addr[5] & 0x3F) | 0xC0;
     gap_random_address_set(addr);
-    printf("Using random static addr %02x:%02x:%02x:%02x:%02x:%02x\n",
-           addr[5], addr[4], addr[3], addr[2], addr[1], addr[0]);
+    PSL_LOG_INFO("Using random static addr %06lx%06lx\n",
+                 (unsigned long)addr[5] << 16 | (unsigned long)addr[4] << 8 | addr[3],
+                 (unsigned long)addr[2] << 16 | (unsigned long)addr[1] << 8 | addr[0]);
 }
 
 static void update_device_name_suffix(void) {
@@ -117,216 +128,312 @@ static void update_device_name_suffix(void) {
     device_name_len = (uint8_t)strlen(device_name);
 }
 
-static void hsv_to_rgb(float h, float s, float v, uint8_t *r, uint8_t *g, uint8_t *b) {
-    h = fmodf(h, 360.0f);
-    if (h < 0.0f) {
-        h += 360.0f;
-    }
-
-    float c = v * s;
-    float x = c * (1.0f - fabsf(fmodf(h / 60.0f, 2.0f) - 1.0f));
-    float m = v - c;
-    float r1 = 0.0f;
-    float g1 = 0.0f;
-    float b1 = 0.0f;
-
-    if (h < 60.0f) {
-        r1 = c;
-        g1 = x;
-    } else if (h < 120.0f) {
-        r1 = x;
-        g1 = c;
-    } else if (h < 180.0f) {
-        g1 = c;
-        b1 = x;
-    } else if (h < 240.0f) {
-        g1 = x;
-        b1 = c;
-    } else if (h < 300.0f) {
-        r1 = x;
-        b1 = c;
-    } else {
-        r1 = c;
-        b1 = x;
-    }
-
-    *r = (uint8_t)clampf((r1 + m) * 255.0f, 0.0f, 255.0f);
-    *g = (uint8_t)clampf((g1 + m) * 255.0f, 0.0f, 255.0f);
-    *b = (uint8_t)clampf((b1 + m) * 255.0f, 0.0f, 255.0f);
-}
-
-static void ws2812_init(void) {
-    led_offset = pio_add_program(led_pio, &ws2812_program);
-    ws2812_program_init(led_pio, led_sm, led_offset, LED_PIN, 800000.0f, false);
+static void reset_system(void) {
+    watchdog_reboot(0, 0, 0);
 }
 
-static void ws2812_write_color(uint32_t grb) {
-    for (uint i = 0; i < NUM_LEDS; ++i) {
-        uint32_t color = (i >= segment_start && i <= segment_end) ? grb : 0;
-        pio_sm_put_blocking(led_pio, led_sm, color << 8u);
+/*
+ * CFG: a new strip geometry takes effect on the next boot. Core1 is halted
+ * for the flash write, so the reboot follows straight away. Any accepted
+ * strip fits one 0xA5 frame, except past RENDERER_UPLOAD_PIXELS LEDs with
+ * run-list output, where the app must split the strip over several.
+ */
+static void handle_config_packet(const uint8_t *packet, size_t len) {
+    strip_config_t config;
+    if (!command_parse_config(packet, len, &config)) {
+        PSL_LOG_WARN("Malformed CFG packet (%u bytes)\n", (unsigned)len);
+        return;
     }
-}
-
-static void clamp_segment_bounds(void) {
-    if (segment_start >= NUM_LEDS) {
-        segment_start = NUM_LEDS - 1;
+    if (!strip_config_validate(&config)) {
+        return;
     }
-    if (segment_end >= NUM_LEDS) {
-        segment_end = NUM_LEDS - 1;
+    PSL_LOG_INFO("Config: %u LEDs, %s, %u chain(s); saving and rebooting\n", config.led_count,
+                 strip_config_order_name(config.color_order), config.chain_count);
+    if (config.led_count > RENDERER_UPLOAD_PIXELS) {
+        PSL_LOG_INFO("Config: 0xA5 frames cover at most %u LEDs each\n", (unsigned)RENDERER_UPLOAD_PIXELS);
     }
-    if (segment_start > segment_end) {
-        segment_end = segment_start;
+    renderer_stop();
+    if (!strip_config_save(&config)) {
+        PSL_LOG_ERROR("Config: flash write did not verify\n");
     }
+    reset_system();
 }
 
-static void set_segment_start(uint32_t start) {
-    uint32_t index = start;
-    if (index >= NUM_LEDS) {
-        index = NUM_LEDS - 1;
-    }
-    segment_start = (uint16_t)index;
-    clamp_segment_bounds();
-    render_color_from_state();
+static void render_stats_timer_handler(btstack_timer_source_t *ts) {
+    render_stats_t stats;
+    renderer_get_stats(&stats);
+    if (stats.requested != render_stats_reported.requested || stats.dropped != render_stats_reported.dropped) {
+        PSL_LOG_INFO("Render: %lu requested, %lu rendered, %lu coalesced, %lu dropped\n",
+                     (unsigned long)stats.requested,
+                     (unsigned long)stats.rendered,
+                     (unsigned long)stats.coalesced,
+                     (unsigned long)stats.dropped);
+        PSL_LOG_INFO("Render: %lu frames out, %lu unchanged, render %lu us (max %lu us)\n",
+                     (unsigned long)stats.frames_out,
+                     (unsigned long)stats.frames_unchanged,
+                     (unsigned long)stats.render_us,
+                     (unsigned long)stats.render_us_max);
+        render_stats_reported = stats;
+    }
+    if (motion_stats.received != motion_stats_reported.received) {
+        PSL_LOG_INFO("Motion: %lu received, %lu lost, %lu stale\n",
+                     (unsigned long)motion_stats.received,
+                     (unsigned long)motion_stats.lost,
+                     (unsigned long)motion_stats.stale);
+        motion_stats_reported = motion_stats;
+    }
+    if (frame_delta_rejected != frame_delta_rejected_reported) {
+        PSL_LOG_INFO("Frames: %lu deltas rejected (no base or out of sequence)\n",
+                     (unsigned long)frame_delta_rejected);
+        frame_delta_rejected_reported = frame_delta_rejected;
+    }
+    if (reassembly.dropped != reassembly_dropped_reported) {
+        PSL_LOG_INFO("Fragments: %lu frames reassembled, %lu dropped, %lu without a buffer\n",
+                     (unsigned long)reassembly.completed,
+                     (unsigned long)reassembly.dropped,
+                     (unsigned long)upload_unavailable);
+        reassembly_dropped_reported = reassembly.dropped;
+    }
+    ble_link_report(RENDER_STATS_PERIOD_MS);
+    btstack_run_loop_set_timer(ts, RENDER_STATS_PERIOD_MS);
+    btstack_run_loop_add_timer(ts);
 }
 
-static void set_segment_end(uint32_t end) {
-    uint32_t index = end;
-    if (index >= NUM_LEDS) {
-        index = NUM_LEDS - 1;
-    }
-    segment_end = (uint16_t)index;
-    clamp_segment_bounds();
-    render_color_from_state();
+/* Packets dropped before reaching the renderer's queue. */
+static uint32_t protocol_packet_drops(void) {
+    return reassembly.dropped + upload_unavailable + frame_delta_rejected + motion_stats.stale;
 }
 
-static float current_hue = 25.0f;
-static float current_saturation = 1.0f;
-static float current_brightness = 125.0f / 255.0f;
-static float hue_offset = 0.0f;
-static float brightness_offset = 0.0f;
-
-static void render_color_from_state(void) {
-    float adjusted_hue = fmodf(current_hue + hue_offset, 360.0f);
-    if (adjusted_hue < 0.0f) {
-        adjusted_hue += 360.0f;
-    }
-    float adjusted_brightness = clampf(
-        current_brightness + brightness_offset,
-        MIN_BRIGHTNESS_NORMALIZED,
-        MAX_BRIGHTNESS_NORMALIZED
-    );
-
-    uint8_t r, g, b;
-    hsv_to_rgb(adjusted_hue, current_saturation, adjusted_brightness, &r, &g, &b);
-    uint32_t color = ((uint32_t)g << 16) | ((uint32_t)r << 8) | b;
-    ws2812_write_color(color);
+static void init_render_stats(void) {
+    btstack_run_loop_set_timer_handler(&render_stats_timer, &render_stats_timer_handler);
+    btstack_run_loop_set_timer(&render_stats_timer, RENDER_STATS_PERIOD_MS);
+    btstack_run_loop_add_timer(&render_stats_timer);
 }
 
-static void set_hue(float degrees) {
-    float normalized = fmodf(degrees, 360.0f);
-    if (normalized < 0.0f) {
-        normalized += 360.0f;
+static void handle_motion_packet(const uint8_t *packet, size_t len) {
+    psl_command_t command;
+    switch (command_parse_text(packet, len, &command)) {
+    case COMMAND_PARSE_OK:
+        frame_base.valid = false;
+        renderer_post(&command);
+        break;
+    case COMMAND_PARSE_RESET:
+        reset_system();
+        break;
+    case COMMAND_PARSE_CONFIG:
+        handle_config_packet(packet, len);
+        break;
+    default:
+        PSL_LOG_WARN("Unrecognized BLE packet (%u bytes, first 0x%02x)\n", (unsigned)len, packet[0]);
+        break;
     }
-    current_hue = normalized;
-    hue_offset = 0.0f;
-    render_color_from_state();
-}
-
-static void set_brightness(float percent) {
-    float normalized = percent / 100.0f;
-    current_brightness = clampf(
-        normalized,
-        MIN_BRIGHTNESS_NORMALIZED,
-        MAX_BRIGHTNESS_NORMALIZED
-    );
-    brightness_offset = 0.0f;
-    render_color_from_state();
 }
 
-static void reset_system(void) {
-    watchdog_reboot(0, 0, 0);
+/* Binary motion (0xA2): integer angles, no text parsing. */
+static bool handle_binary_motion_packet(const uint8_t *data, size_t len) {
+    motion_packet_t packet;
+    motion_parse_status_t status = motion_packet_decode(data, len, &packet);
+    if (status == MOTION_PARSE_NOT_MOTION) {
+        return false;
+    }
+    if (status == MOTION_PARSE_TRUNCATED) {
+        PSL_LOG_WARN("Motion packet truncated (%u bytes)\n", (unsigned)len);
+        return true;
+    }
+    if (!motion_stream_accept(&motion_stats, &packet)) {
+        return true;
+    }
+    psl_command_t command;
+    command.type = PSL_CMD_MOTION;
+    command.u.motion.pitch = motion_angle_to_radians(packet.pitch);
+    command.u.motion.roll = motion_angle_to_radians(packet.roll);
+    command.u.motion.yaw = motion_angle_to_radians(packet.yaw);
+    frame_base.valid = false;
+    renderer_post(&command);
+    return true;
 }
 
-static void render_motion_color(float pitch, float roll, float yaw) {
-    float norm_roll = clampf((roll + 3.14159f) / (2.0f * 3.14159f), 0.0f, 1.0f);
-    float norm_yaw = clampf((yaw + 3.14159f) / (2.0f * 3.14159f), 0.0f, 1.0f);
-    float norm_pitch = clampf((pitch + (3.14159f / 2.0f)) / 3.14159f, 0.0f, 1.0f);
-    float hue = fmodf(norm_yaw * 360.0f + norm_roll * 120.0f, 360.0f);
-    float saturation = clampf(0.35f + norm_roll * 0.65f, 0.2f, 1.0f);
-    float brightness = clampf(
-        0.2f + norm_pitch * 0.8f,
-        MIN_BRIGHTNESS_NORMALIZED,
-        MAX_BRIGHTNESS_NORMALIZED
-    );
-
-    current_hue = hue;
-    current_saturation = saturation;
-    current_brightness = brightness;
-    render_color_from_state();
+/* Core1 never sees this frame, so deltas against it would diverge. */
+static void drop_staged_frame(void) {
+    renderer_discard();
+    frame_base.valid = false;
 }
 
-static void adjust_hue(float delta) {
-    hue_offset = fmodf(hue_offset + delta, 360.0f);
-    if (hue_offset < 0.0f) {
-        hue_offset += 360.0f;
+static void publish_staged_frame(void) {
+    psl_command_t command;
+    command.type = PSL_CMD_FRAME_COMMIT;
+    if (!renderer_stage(&command)) {
+        drop_staged_frame();
+        return;
     }
-    render_color_from_state();
+    renderer_publish();
 }
 
-static void adjust_brightness(float delta) {
-    float desired = clampf(
-        current_brightness + brightness_offset + delta,
-        MIN_BRIGHTNESS_NORMALIZED,
-        MAX_BRIGHTNESS_NORMALIZED
-    );
-    brightness_offset = desired - current_brightness;
-    render_color_from_state();
+/*
+ * Decode a 0xA0 run-length frame in place from the ATT buffer. Each run is
+ * staged as a command and the whole frame is published with its commit, so
+ * core1 never renders a partial frame. Returns false if this isn't a frame.
+ */
+static bool handle_frame_packet(const uint8_t *data, size_t len) {
+    frame_reader_t reader;
+    frame_parse_status_t status = frame_reader_init(&reader, data, len);
+    if (status == FRAME_PARSE_NOT_FRAME) {
+        return false;
+    }
+    if (status == FRAME_PARSE_BAD_VERSION) {
+        PSL_LOG_WARN("Unsupported frame version %u\n", data[1]);
+        return true;
+    }
+
+    psl_command_t command;
+    command.type = PSL_CMD_FRAME_RUN;
+    frame_base_begin(&frame_base);
+    while (frame_reader_next(&reader, &command.u.run)) {
+        frame_base_append(&frame_base, &command.u.run);
+        if (!renderer_stage(&command)) {
+            drop_staged_frame();
+            return true;
+        }
+    }
+    if (reader.truncated) {
+        PSL_LOG_WARN("Frame truncated (%u bytes)\n", (unsigned)len);
+    }
+    publish_staged_frame();
+    return true;
 }
 
-static void handle_motion_packet(const char *packet, size_t len) {
-    char buffer[PACKET_BUFFER];
-    size_t copy_len = len < sizeof(buffer) - 1 ? len : sizeof(buffer) - 1;
-    memcpy(buffer, packet, copy_len);
-    buffer[copy_len] = '\0';
-
-    float pitch = 0.0f;
-    float roll = 0.0f;
-    float yaw = 0.0f;
-    float delta = 0.0f;
-    if (strncmp(buffer, "RESET", 5) == 0) {
-        reset_system();
-        return;
+/* Delta (0xA3): only changed runs are staged, core1 paints them in place. */
+static bool handle_frame_delta_packet(const uint8_t *data, size_t len) {
+    frame_delta_reader_t reader;
+    frame_parse_status_t status = frame_delta_reader_init(&reader, &frame_base, data, len);
+    switch (status) {
+    case FRAME_PARSE_OK:
+        break;
+    case FRAME_PARSE_NOT_FRAME:
+        return false;
+    case FRAME_PARSE_BAD_VERSION:
+        PSL_LOG_WARN("Unsupported delta frame version %u\n", data[1]);
+        return true;
+    case FRAME_PARSE_TRUNCATED:
+        PSL_LOG_WARN("Delta frame truncated (%u bytes)\n", (unsigned)len);
+        return true;
+    default:
+        /* No matching base or a missed delta: wait for the next full frame. */
+        frame_delta_rejected++;
+        return true;
     }
-    if (sscanf(buffer, "H_SET,%f", &delta) == 1) {
-        set_hue(delta);
-        return;
+
+    psl_command_t command;
+    command.type = PSL_CMD_FRAME_RUN;
+    while (frame_delta_reader_next(&reader, &command.u.run)) {
+        if (!renderer_stage(&command)) {
+            drop_staged_frame();
+            return true;
+        }
     }
-    if (sscanf(buffer, "B_SET,%f", &delta) == 1) {
-        set_brightness(delta);
-        return;
+    publish_staged_frame();
+    return true;
+}
+
+/*
+ * Pixel frame (0xA5). Core1 copies straight out of an upload buffer; a packet
+ * that isn't already in one (a single unfragmented write) is copied in first.
+ * The upload buffer always ends up handed to core1 or released.
+ */
+static bool handle_pixel_frame_packet(const uint8_t *data, size_t len, uint8_t *upload) {
+    if (!data || len == 0 || data[0] != PSL_FRAME_PIXELS_COMMAND_ID) {
+        return false;
+    }
+    if (!upload) {
+        if (len > RENDERER_UPLOAD_BYTES) {
+            PSL_LOG_WARN("Pixel frame too large (%u bytes)\n", (unsigned)len);
+            return true;
+        }
+        upload = renderer_upload_acquire();
+        if (!upload) {
+            upload_unavailable++;
+            return true;
+        }
+        memcpy(upload, data, len);
     }
-    if (sscanf(buffer, "H,%f", &delta) == 1) {
-        adjust_hue(delta);
-        return;
+
+    psl_command_t command;
+    frame_parse_status_t status = frame_pixels_parse(upload, len, &command.u.pixels);
+    if (status != FRAME_PARSE_OK) {
+        PSL_LOG_WARN("Bad pixel frame (status %d, %u bytes)\n", (int)status, (unsigned)len);
+        renderer_upload_release(upload);
+        return true;
     }
-    if (sscanf(buffer, "B,%f", &delta) == 1) {
-        adjust_brightness(delta);
-        return;
+    command.type = PSL_CMD_FRAME_PIXELS;
+    if (!renderer_stage(&command)) {
+        drop_staged_frame();
+        renderer_upload_release(upload);
+        return true;
     }
-    unsigned long segment_idx = 0;
-    if (sscanf(buffer, "SEG_START,%lu", &segment_idx) == 1) {
-        set_segment_start(segment_idx > 0 ? segment_idx - 1 : 0);
-        return;
+    frame_base.valid = false;
+    publish_staged_frame();
+    return true;
+}
+
+static void handle_single_packet(const uint8_t *data, size_t len);
+
+static void reassembly_timeout_handler(btstack_timer_source_t *ts) {
+    (void)ts;
+    frame_reassembly_abort(&reassembly);
+}
+
+/* Fragment (0xA4): reassemble into an upload buffer, then dispatch the payload. */
+static bool handle_fragment_packet(const uint8_t *data, size_t len) {
+    frame_fragment_t fragment;
+    fragment_parse_status_t status = frame_fragment_parse(data, len, &fragment);
+    if (status == FRAGMENT_PARSE_NOT_FRAGMENT) {
+        return false;
+    }
+    if (status == FRAGMENT_PARSE_INVALID) {
+        PSL_LOG_WARN("Bad fragment header (%u bytes)\n", (unsigned)len);
+        return true;
+    }
+    if (!reassembly.buffer) {
+        /* No frame can be in progress without a buffer; only fragment 0
+         * starts one, so don't tie up a buffer for a stray fragment. */
+        if (fragment.index != 0) {
+            return true;
+        }
+        uint8_t *buffer = renderer_upload_acquire();
+        if (!buffer) {
+            upload_unavailable++;
+            return true;
+        }
+        frame_reassembly_set_buffer(&reassembly, buffer, RENDERER_UPLOAD_BYTES);
     }
-    if (sscanf(buffer, "SEG_END,%lu", &segment_idx) == 1) {
-        set_segment_end(segment_idx > 0 ? segment_idx - 1 : 0);
-        return;
+
+    switch (frame_reassembly_add(&reassembly, &fragment)) {
+    case REASSEMBLY_PENDING:
+        /* An inactivity timeout: long frames at a small MTU take many intervals. */
+        btstack_run_loop_remove_timer(&reassembly_timer);
+        btstack_run_loop_set_timer(&reassembly_timer, REASSEMBLY_TIMEOUT_MS);
+        btstack_run_loop_add_timer(&reassembly_timer);
+        break;
+    case REASSEMBLY_COMPLETE: {
+        btstack_run_loop_remove_timer(&reassembly_timer);
+        uint8_t *payload = reassembly.buffer;
+        const size_t payload_len = reassembly.len;
+        if (payload_len == 0 || payload[0] == PSL_FRAGMENT_COMMAND_ID) {
+            break;
+        }
+        if (payload[0] == PSL_FRAME_PIXELS_COMMAND_ID) {
+            /* Ownership moves to core1; take a fresh buffer next frame. */
+            frame_reassembly_set_buffer(&reassembly, NULL, 0);
+            handle_pixel_frame_packet(payload, payload_len, payload);
+        } else {
+            handle_single_packet(payload, payload_len);
+        }
+        break;
     }
-    if (sscanf(buffer, "%f,%f,%f", &pitch, &roll, &yaw) == 3) {
-        render_motion_color(pitch, roll, yaw);
-        return;
+    default:
+        break;
     }
-    printf("Unrecognized BLE packet: '%s'\n", buffer);
+    return true;
 }
 
 static void log_att_data_packet(const uint8_t *packet, uint16_t size) {
@@ -334,92 +441,96 @@ static void log_att_data_packet(const uint8_t *packet, uint16_t size) {
         return;
     }
     const uint8_t opcode = packet[0];
-    printf("ATT data opcode=0x%02x len=%u", opcode, size);
+    const uint16_t arg0 = size >= 3 ? little_endian_read_16(packet, 1) : 0;
+    const uint16_t arg1 = size >= 5 ? little_endian_read_16(packet, 3) : 0;
     switch (opcode) {
     case ATT_EXCHANGE_MTU_REQUEST:
-        if (size >= 3) {
-            const uint16_t client_rx_mtu = little_endian_read_16(packet, 1);
-            printf(" MTU_REQ client=%u", client_rx_mtu);
-        }
+        PSL_LOG_DEBUG("ATT MTU_REQ client=%u\n", arg0);
         break;
     case ATT_EXCHANGE_MTU_RESPONSE:
-        if (size >= 3) {
-            const uint16_t server_rx_mtu = little_endian_read_16(packet, 1);
-            printf(" MTU_RSP server=%u", server_rx_mtu);
-        }
+        PSL_LOG_DEBUG("ATT MTU_RSP server=%u\n", arg0);
         break;
     case ATT_READ_BY_GROUP_TYPE_REQUEST:
     case ATT_READ_BY_TYPE_REQUEST:
-        if (size >= 5) {
-            const uint16_t start = little_endian_read_16(packet, 1);
-            const uint16_t end = little_endian_read_16(packet, 3);
-            printf(" range=0x%04x-0x%04x", start, end);
-        }
+        PSL_LOG_DEBUG("ATT opcode=0x%02x len=%u range=0x%04x-0x%04x\n", opcode, size, arg0, arg1);
         break;
     case ATT_READ_REQUEST:
     case ATT_READ_BLOB_REQUEST:
     case ATT_READ_MULTIPLE_REQUEST:
     case ATT_READ_MULTIPLE_VARIABLE_REQ:
-        if (size >= 3) {
-            const uint16_t handle = little_endian_read_16(packet, 1);
-            printf(" read_handle=0x%04x", handle);
-        }
+        PSL_LOG_DEBUG("ATT opcode=0x%02x len=%u read_handle=0x%04x\n", opcode, size, arg0);
         break;
     case ATT_WRITE_REQUEST:
     case ATT_WRITE_COMMAND:
     case ATT_SIGNED_WRITE_COMMAND:
-        if (size >= 3) {
-            const uint16_t handle = little_endian_read_16(packet, 1);
-            printf(" write_handle=0x%04x payload=%u", handle, size - 3);
-        }
+        PSL_LOG_DEBUG("ATT opcode=0x%02x write_handle=0x%04x payload=%u\n", opcode, arg0,
+                      size >= 3 ? size - 3 : 0);
         break;
     default:
+        PSL_LOG_DEBUG("ATT opcode=0x%02x len=%u\n", opcode, size);
         break;
     }
-    printf(" payload:");
-    for (uint16_t i = 0; i < size; ++i) {
-        printf(" %02x", packet[i]);
-    }
-    printf("\n");
 }
 
 static void att_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size) {
     (void)channel;
-    (void)size;
+    ble_link_handle_event(packet_type, packet, size);
     if (packet_type == ATT_DATA_PACKET) {
         log_att_data_packet(packet, size);
     } else if (packet_type == HCI_EVENT_PACKET) {
         const uint8_t event_type = hci_event_packet_get_type(packet);
         if (event_type == ATT_EVENT_CONNECTED) {
-            printf("ATT server connected handle=0x%04x\n", att_event_connected_get_handle(packet));
+            PSL_LOG_INFO("ATT server connected handle=0x%04x\n", att_event_connected_get_handle(packet));
         } else if (event_type == ATT_EVENT_DISCONNECTED) {
-            printf("ATT server disconnected handle=0x%04x\n",
+            PSL_LOG_INFO("ATT server disconnected handle=0x%04x\n",
                    att_event_disconnected_get_handle(packet));
         }
     }
 }
 
+/* Everything except fragments; also used for reassembled payloads. */
+static void handle_single_packet(const uint8_t *data, size_t len) {
+    if (handle_binary_motion_packet(data, len)) {
+        return;
+    }
+    if (handle_frame_packet(data, len) || handle_frame_delta_packet(data, len) ||
+        handle_pixel_frame_packet(data, len, NULL)) {
+        return;
+    }
+
+    PSL_LOG_DEBUG("BLE text write (%u bytes)\n", (unsigned)len);
+
+    handle_motion_packet(data, len);
+}
+
+static uint16_t ble_read_callback(hci_con_handle_t con_handle, uint16_t attribute_handle,
+                                  uint16_t offset, uint8_t *buffer, uint16_t buffer_size) {
+    (void)con_handle;
+    if (attribute_handle == ble_telemetry_value_handle) {
+        return telemetry_read(offset, buffer, buffer_size);
+    }
+    return 0;
+}
+
 static int ble_command_write_callback(hci_con_handle_t con_handle, uint16_t attribute_handle,
                                       uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size) {
-    (void)con_handle;
+    latency_trace_write_begin();
     (void)offset;
 
+    if (attribute_handle == ble_telemetry_config_handle) {
+        return telemetry_write_client_config(con_handle, buffer, buffer_size);
+    }
     if (attribute_handle != ble_command_value_handle) {
-        printf("Write to unexpected handle 0x%04x (%u bytes)\n", attribute_handle, buffer_size);
+        PSL_LOG_WARN("Write to unexpected handle 0x%04x (%u bytes)\n", attribute_handle, buffer_size);
         return ATT_ERROR_ATTRIBUTE_NOT_FOUND;
     }
     if (transaction_mode != ATT_TRANSACTION_MODE_NONE || !buffer || buffer_size == 0) {
         return 0;
     }
-
-    char payload[PACKET_BUFFER];
-    size_t copy_len = buffer_size < sizeof(payload) - 1 ? buffer_size : sizeof(payload) - 1;
-    memcpy(payload, buffer, copy_len);
-    payload[copy_len] = '\0';
-
-    printf("BLE write (%u bytes): %s\n", buffer_size, payload);
-
-    handle_motion_packet(payload, copy_len);
+    ble_link_note_write(buffer_size);
+    if (!handle_fragment_packet(buffer, buffer_size)) {
+        handle_single_packet(buffer, buffer_size);
+    }
     return 0;
 }
 
@@ -456,7 +567,7 @@ static void start_advertising(void) {
     gap_scan_response_set_data(scan_data_len, scan_data);
     gap_advertisements_enable(1);
     advertising_active = true;
-    printf("Advertising %s (%u adv bytes, %u scan bytes)\n",
+    PSL_LOG_INFO("Advertising %s (%u adv bytes, %u scan bytes)\n",
            BLE_DEVICE_NAME, adv_data_len, scan_data_len);
 }
 
@@ -470,17 +581,17 @@ static void stop_advertising(void) {
 
 static void btstack_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size) {
     (void)channel;
-    (void)size;
     if (packet_type != HCI_EVENT_PACKET) {
         return;
     }
+    ble_link_handle_event(packet_type, packet, size);
     const uint8_t event_type = hci_event_packet_get_type(packet);
     switch (event_type) {
     case BTSTACK_EVENT_STATE: {
         const uint8_t state = btstack_event_state_get_state(packet);
-        printf("BTstack state %u\n", state);
+        PSL_LOG_INFO("BTstack state %u\n", state);
         if (state == HCI_STATE_WORKING) {
-            printf("BTstack ready, enabling advertising\n");
+            PSL_LOG_INFO("BTstack ready, enabling advertising\n");
             configure_random_address();
             start_advertising();
         }
@@ -489,16 +600,19 @@ static void btstack_event_handler(uint8_t packet_type, uint16_t channel, uint8_t
     case HCI_EVENT_LE_META: {
         const uint8_t subevent = hci_event_le_meta_get_subevent_code(packet);
         if (subevent == HCI_SUBEVENT_LE_CONNECTION_COMPLETE) {
-            printf("LE connected handle=0x%04x status=%u\n",
+            PSL_LOG_INFO("LE connected handle=0x%04x status=%u\n",
                    hci_subevent_le_connection_complete_get_connection_handle(packet),
                    hci_subevent_le_connection_complete_get_status(packet));
         }
         break;
     }
     case HCI_EVENT_DISCONNECTION_COMPLETE:
-        printf("LE disconnected handle=0x%04x reason=0x%02x\n",
+        PSL_LOG_INFO("LE disconnected handle=0x%04x reason=0x%02x\n",
                hci_event_disconnection_complete_get_connection_handle(packet),
                hci_event_disconnection_complete_get_reason(packet));
+        telemetry_disconnected();
+        /* The next client numbers its motion packets from scratch. */
+        motion_stats.have_seq = false;
         stop_advertising();
         start_advertising();
         break;
@@ -510,9 +624,12 @@ static void btstack_event_handler(uint8_t packet_type, uint16_t channel, uint8_t
 static void init_ble_service(void) {
     l2cap_init();
     sm_init();
+    ble_link_init();
 
     update_device_name_suffix();
-    att_server_init(profile_data, NULL, ble_command_write_callback);
+    btstack_run_loop_set_timer_handler(&reassembly_timer, &reassembly_timeout_handler);
+    telemetry_init(ble_telemetry_value_handle, &protocol_packet_drops);
+    att_server_init(profile_data, ble_read_callback, ble_command_write_callback);
     att_server_register_packet_handler(att_packet_handler);
 
     prepare_ble_advertising_payload();
@@ -539,12 +656,28 @@ int main(void) {
         return 1;
     }
 
-    ws2812_init();
-    render_color_from_state();
+#if PSL_ENABLE_BENCHMARKS
+    bench_run_all();
+#endif
+
+    telemetry_paint_stacks();
+    renderer_launch();
 
+    init_render_stats();
     init_ble_service();
 
-    btstack_run_loop_execute();
+    /*
+     * BTstack runs from the background async context (IRQ driven), so this
+     * thread is idle time: the only place log output touches USB stdio.
+     */
+    for (;;) {
+        if (getchar_timeout_us(0) == CONSOLE_LATENCY_DUMP) {
+            latency_trace_dump();
+        }
+        if (log_ring_drain(LOG_DRAIN_BATCH) < LOG_DRAIN_BATCH) {
+            sleep_ms(LOG_IDLE_SLEEP_MS);
+        }
+    }
 
     cyw43_arch_deinit();
     return 0;
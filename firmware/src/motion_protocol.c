@@ -0,0 +1,92 @@
+#include "motion_protocol.h"
+
+#include <math.h>
+
+/* Gaps larger than this are treated as a sender restart, not loss. */
+#define MOTION_SEQ_MAX_GAP 1024u
+
+#define MOTION_PI 3.14159f
+#define MOTION_MIN_BRIGHTNESS 0.05f
+
+static inline uint16_t read_u16_le(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline float clampf(float value, float min, float max) {
+    if (value < min) {
+        return min;
+    }
+    if (value > max) {
+        return max;
+    }
+    return value;
+}
+
+motion_parse_status_t motion_packet_decode(const uint8_t *data, size_t len, motion_packet_t *packet) {
+    if (!data || len < 1 || data[0] != PSL_MOTION_COMMAND_ID) {
+        return MOTION_PARSE_NOT_MOTION;
+    }
+    if (len < PSL_MOTION_BASE_LEN) {
+        return MOTION_PARSE_TRUNCATED;
+    }
+    const uint8_t flags = data[1];
+    size_t need = PSL_MOTION_BASE_LEN;
+    if (flags & PSL_MOTION_FLAG_SEQ) {
+        need += 2u;
+    }
+    if (flags & PSL_MOTION_FLAG_TIMESTAMP) {
+        need += 4u;
+    }
+    if (len < need) {
+        return MOTION_PARSE_TRUNCATED;
+    }
+
+    packet->flags = flags;
+    packet->pitch = (int16_t)read_u16_le(data + 2);
+    packet->roll = (int16_t)read_u16_le(data + 4);
+    packet->yaw = (int16_t)read_u16_le(data + 6);
+    packet->seq = 0;
+    packet->timestamp_ms = 0;
+
+    const uint8_t *p = data + PSL_MOTION_BASE_LEN;
+    if (flags & PSL_MOTION_FLAG_SEQ) {
+        packet->seq = read_u16_le(p);
+        p += 2;
+    }
+    if (flags & PSL_MOTION_FLAG_TIMESTAMP) {
+        packet->timestamp_ms = (uint32_t)read_u16_le(p) | ((uint32_t)read_u16_le(p + 2) << 16);
+    }
+    return MOTION_PARSE_OK;
+}
+
+bool motion_stream_accept(motion_stream_stats_t *stats, const motion_packet_t *packet) {
+    stats->received++;
+    if (!(packet->flags & PSL_MOTION_FLAG_SEQ)) {
+        return true;
+    }
+    if (stats->have_seq) {
+        uint16_t gap = (uint16_t)(packet->seq - stats->last_seq);
+        if (gap == 0 || gap > (uint16_t)(0x10000u - MOTION_SEQ_MAX_GAP)) {
+            stats->stale++;
+            return false;
+        }
+        if (gap <= MOTION_SEQ_MAX_GAP) {
+            stats->lost += gap - 1u;
+        }
+    }
+    stats->last_seq = packet->seq;
+    stats->have_seq = true;
+    return true;
+}
+
+motion_color_t motion_color_from_angles(float pitch, float roll, float yaw) {
+    float norm_roll = clampf((roll + MOTION_PI) / (2.0f * MOTION_PI), 0.0f, 1.0f);
+    float norm_yaw = clampf((yaw + MOTION_PI) / (2.0f * MOTION_PI), 0.0f, 1.0f);
+    float norm_pitch = clampf((pitch + (MOTION_PI / 2.0f)) / MOTION_PI, 0.0f, 1.0f);
+    motion_color_t color = {
+        .hue = fmodf(norm_yaw * 360.0f + norm_roll * 120.0f, 360.0f),
+        .saturation = clampf(0.35f + norm_roll * 0.65f, 0.2f, 1.0f),
+        .brightness = clampf(0.2f + norm_pitch * 0.8f, MOTION_MIN_BRIGHTNESS, 1.0f),
+    };
+    return color;
+}
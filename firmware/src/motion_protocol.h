@@ -0,0 +1,72 @@
+#ifndef MOTION_PROTOCOL_H
+#define MOTION_PROTOCOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Binary motion packet (command 0xA2), the compact form of the ASCII
+ * "<pitch>,<roll>,<yaw>" triplet:
+ *
+ *   [0xA2][flags][pitch i16 LE][roll i16 LE][yaw i16 LE]    8 bytes
+ *   [seq u16 LE]                if flags & PSL_MOTION_FLAG_SEQ
+ *   [timestamp_ms u32 LE]       if flags & PSL_MOTION_FLAG_TIMESTAMP
+ *
+ * Angles are radians in Q2.13 (8192 == 1 rad), which covers +/-4 rad with
+ * ~0.007 degree resolution. Optional fields appear in flag-bit order.
+ */
+
+#define PSL_MOTION_COMMAND_ID 0xA2
+#define PSL_MOTION_FLAG_SEQ 0x01u
+#define PSL_MOTION_FLAG_TIMESTAMP 0x02u
+#define PSL_MOTION_BASE_LEN 8u
+#define PSL_MOTION_ANGLE_ONE 8192.0f
+
+typedef struct {
+    int16_t pitch;
+    int16_t roll;
+    int16_t yaw;
+    uint8_t flags;
+    uint16_t seq;
+    uint32_t timestamp_ms;
+} motion_packet_t;
+
+typedef enum {
+    MOTION_PARSE_OK = 0,
+    MOTION_PARSE_NOT_MOTION,
+    MOTION_PARSE_TRUNCATED
+} motion_parse_status_t;
+
+motion_parse_status_t motion_packet_decode(const uint8_t *data, size_t len, motion_packet_t *packet);
+
+static inline float motion_angle_to_radians(int16_t angle) {
+    return (float)angle * (1.0f / PSL_MOTION_ANGLE_ONE);
+}
+
+/*
+ * The renderer's motion-to-colour mapping: yaw plus a third of roll picks
+ * the hue (degrees), roll the saturation and pitch the brightness (0..1).
+ */
+typedef struct {
+    float hue;
+    float saturation;
+    float brightness;
+} motion_color_t;
+
+motion_color_t motion_color_from_angles(float pitch, float roll, float yaw);
+
+/* Sequence tracking for streams that carry PSL_MOTION_FLAG_SEQ. */
+typedef struct {
+    uint32_t received;
+    uint32_t lost;
+    uint32_t stale;
+    uint16_t last_seq;
+    bool have_seq;
+} motion_stream_stats_t;
+
+/* Returns false for a packet at or behind the last sequence number seen,
+ * which the caller should drop. Packets without a sequence always pass. */
+bool motion_stream_accept(motion_stream_stats_t *stats, const motion_packet_t *packet);
+
+#endif
@@ -0,0 +1,148 @@
+#include "pixel_pack.h"
+
+#include <stdbool.h>
+
+/*
+ * 8-bit to 16-bit gamma curve, gamma 2.2:
+ *   gamma16_table[i] = round(65535 * (i / 255.0) ** 2.2)
+ */
+static const uint16_t gamma16_table[256] = {
+        0,     0,     2,     4,     7,    11,    17,    24,
+       32,    42,    53,    65,    79,    94,   111,   129,
+      148,   169,   192,   216,   242,   270,   299,   330,
+      362,   396,   432,   469,   508,   549,   591,   635,
+      681,   729,   779,   830,   883,   938,   995,  1053,
+     1113,  1175,  1239,  1305,  1373,  1443,  1514,  1587,
+     1663,  1740,  1819,  1900,  1983,  2068,  2155,  2243,
+     2334,  2427,  2521,  2618,  2717,  2817,  2920,  3024,
+     3131,  3240,  3350,  3463,  3578,  3694,  3813,  3934,
+     4057,  4182,  4309,  4438,  4570,  4703,  4838,  4976,
+     5115,  5257,  5401,  5547,  5695,  5845,  5998,  6152,
+     6309,  6468,  6629,  6792,  6957,  7124,  7294,  7466,
+     7640,  7816,  7994,  8175,  8358,  8543,  8730,  8919,
+     9111,  9305,  9501,  9699,  9900, 10102, 10307, 10515,
+    10724, 10936, 11150, 11366, 11585, 11806, 12029, 12254,
+    12482, 12712, 12944, 13179, 13416, 13655, 13896, 14140,
+    14386, 14635, 14885, 15138, 15394, 15652, 15912, 16174,
+    16439, 16706, 16975, 17247, 17521, 17798, 18077, 18358,
+    18642, 18928, 19216, 19507, 19800, 20095, 20393, 20694,
+    20996, 21301, 21609, 21919, 22231, 22546, 22863, 23182,
+    23504, 23829, 24156, 24485, 24817, 25151, 25487, 25826,
+    26168, 26512, 26858, 27207, 27558, 27912, 28268, 28627,
+    28988, 29351, 29717, 30086, 30457, 30830, 31206, 31585,
+    31966, 32349, 32735, 33124, 33514, 33908, 34304, 34702,
+    35103, 35507, 35913, 36321, 36732, 37146, 37562, 37981,
+    38402, 38825, 39252, 39680, 40112, 40546, 40982, 41421,
+    41862, 42306, 42753, 43202, 43654, 44108, 44565, 45025,
+    45487, 45951, 46418, 46888, 47360, 47835, 48313, 48793,
+    49275, 49761, 50249, 50739, 51232, 51728, 52226, 52727,
+    53230, 53736, 54245, 54756, 55270, 55787, 56306, 56828,
+    57352, 57879, 58409, 58941, 59476, 60014, 60554, 61097,
+    61642, 62190, 62741, 63295, 63851, 64410, 64971, 65535,
+};
+
+static uint8_t brightness_level = 255;
+static uint8_t level_lut[256];
+static uint16_t level16_lut[256];
+static bool level_lut_ready = false;
+
+/* Shift of each channel within the PIO word, per pixel_order_t. */
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} order_shifts_t;
+
+static const order_shifts_t order_shift_table[PIXEL_ORDER_COUNT] = {
+    [PIXEL_ORDER_GRB] = {.r = 16, .g = 24, .b = 8},
+    [PIXEL_ORDER_RGB] = {.r = 24, .g = 16, .b = 8},
+    [PIXEL_ORDER_BRG] = {.r = 16, .g = 8, .b = 24},
+    [PIXEL_ORDER_RBG] = {.r = 24, .g = 8, .b = 16},
+    [PIXEL_ORDER_GBR] = {.r = 8, .g = 24, .b = 16},
+    [PIXEL_ORDER_BGR] = {.r = 8, .g = 16, .b = 24},
+};
+static order_shifts_t order_shifts = {.r = 16, .g = 24, .b = 8};
+
+static void rebuild_level_lut(void) {
+    uint32_t scale = (uint32_t)brightness_level * 257u;
+    for (uint32_t i = 0; i < 256u; ++i) {
+        uint16_t level = (uint16_t)(((uint32_t)gamma16_table[i] * scale) >> 16);
+        level16_lut[i] = level;
+        level_lut[i] = (uint8_t)(level >> 8);
+    }
+    level_lut_ready = true;
+}
+
+void pixel_pack_set_brightness(uint8_t level) {
+    if (level == brightness_level && level_lut_ready) {
+        return;
+    }
+    brightness_level = level;
+    rebuild_level_lut();
+}
+
+void pixel_pack_set_order(pixel_order_t order) {
+    if ((uint32_t)order < PIXEL_ORDER_COUNT) {
+        order_shifts = order_shift_table[order];
+    }
+}
+
+uint8_t pixel_pack_brightness(void) {
+    return brightness_level;
+}
+
+void pixel_pack_grb(uint32_t *words, const color_rgb_t *pixels, uint16_t count) {
+    if (!level_lut_ready) {
+        rebuild_level_lut();
+    }
+    const uint8_t *lut = level_lut;
+    const order_shifts_t shift = order_shifts;
+    for (uint16_t i = 0; i < count; ++i) {
+        const color_rgb_t px = pixels[i];
+        words[i] = ((uint32_t)lut[px.g] << shift.g) | ((uint32_t)lut[px.r] << shift.r) |
+                   ((uint32_t)lut[px.b] << shift.b);
+    }
+}
+
+void pixel_pack_linearize(color_rgb16_t *linear, const color_rgb_t *pixels, uint16_t count) {
+    if (!level_lut_ready) {
+        rebuild_level_lut();
+    }
+    const uint16_t *lut = level16_lut;
+    for (uint16_t i = 0; i < count; ++i) {
+        const color_rgb_t px = pixels[i];
+        linear[i].r = lut[px.r];
+        linear[i].g = lut[px.g];
+        linear[i].b = lut[px.b];
+    }
+}
+
+void pixel_pack_dither_reset(pixel_dither_error_t *error, uint16_t count) {
+    for (uint16_t i = 0; i < count; ++i) {
+        /* Golden-ratio steps spread the phases evenly along the strip. */
+        uint8_t phase = (uint8_t)(i * 159u);
+        error[i].r = phase;
+        error[i].g = (uint8_t)(phase + 85u);
+        error[i].b = (uint8_t)(phase + 170u);
+    }
+}
+
+static inline uint32_t dither_channel(uint16_t value, uint8_t *error) {
+    uint32_t acc = (uint32_t)*error + (value & 0xFFu);
+    uint32_t out = ((uint32_t)value >> 8) + (acc >> 8);
+    *error = (uint8_t)acc;
+    return out > 255u ? 255u : out;
+}
+
+void pixel_pack_grb_dithered(uint32_t *words, const color_rgb16_t *linear,
+                             pixel_dither_error_t *error, uint16_t count) {
+    const order_shifts_t shift = order_shifts;
+    for (uint16_t i = 0; i < count; ++i) {
+        const color_rgb16_t px = linear[i];
+        pixel_dither_error_t *err = &error[i];
+        uint32_t g = dither_channel(px.g, &err->g);
+        uint32_t r = dither_channel(px.r, &err->r);
+        uint32_t b = dither_channel(px.b, &err->b);
+        words[i] = (g << shift.g) | (r << shift.r) | (b << shift.b);
+    }
+}
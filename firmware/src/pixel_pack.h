@@ -0,0 +1,57 @@
+#ifndef PIXEL_PACK_H
+#define PIXEL_PACK_H
+
+#include <stdint.h>
+#include "color.h"
+
+/*
+ * Output stage: converts the RGB pixel buffer into PIO words in one pass.
+ * Gamma correction and the global brightness are folded into a single
+ * 256-entry table per channel value, so changing brightness only rebuilds
+ * that table and re-packs; colours are never recomputed.
+ */
+
+/* Byte order on the wire; the PIO words carry it in their top 24 bits. */
+typedef enum {
+    PIXEL_ORDER_GRB = 0,
+    PIXEL_ORDER_RGB,
+    PIXEL_ORDER_BRG,
+    PIXEL_ORDER_RBG,
+    PIXEL_ORDER_GBR,
+    PIXEL_ORDER_BGR,
+    PIXEL_ORDER_COUNT
+} pixel_order_t;
+
+/* Set once before packing; WS2812s are GRB, other chips differ. */
+void pixel_pack_set_order(pixel_order_t order);
+
+/* Global brightness as a linear 0..255 scale applied after gamma. */
+void pixel_pack_set_brightness(uint8_t level);
+uint8_t pixel_pack_brightness(void);
+
+/* Pack pixels as PIO words (top 24 bits) in the wire order, GRB unless
+ * pixel_pack_set_order() chose another. */
+void pixel_pack_grb(uint32_t *words, const color_rgb_t *pixels, uint16_t count);
+
+/*
+ * Temporal dithering path. pixel_pack_linearize() applies gamma and
+ * brightness at 16 bits per channel; pixel_pack_grb_dithered() then emits
+ * the top 8 bits each refresh and carries the low 8 bits in a per-channel
+ * error accumulator, so fractional levels average out over a few frames.
+ */
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} pixel_dither_error_t;
+
+void pixel_pack_linearize(color_rgb16_t *linear, const color_rgb_t *pixels, uint16_t count);
+
+/* Seed accumulators with an ordered pattern so neighbours do not flicker in
+ * phase. */
+void pixel_pack_dither_reset(pixel_dither_error_t *error, uint16_t count);
+
+void pixel_pack_grb_dithered(uint32_t *words, const color_rgb16_t *linear,
+                             pixel_dither_error_t *error, uint16_t count);
+
+#endif
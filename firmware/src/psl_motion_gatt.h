@@ -55,9 +55,17 @@ static const uint8_t profile_data[] =
     // 0x000c VALUE CHARACTERISTIC-0C1D2E3F-4051-6273-8495-A6B7C8D9EAFB - WRITE | WRITE_WITHOUT_RESPONSE | DYNAMIC
     // WRITE_ANYBODY
     0x16, 0x00, 0x0c, 0x03, 0x0c, 0x00, 0xfb, 0xea, 0xd9, 0xc8, 0xb7, 0xa6, 0x95, 0x84, 0x73, 0x62, 0x51, 0x40, 0x3f, 0x2e, 0x1d, 0x0c, 
+    // 0x000d CHARACTERISTIC-0C1D2E3F-4051-6273-8495-A6B7C8D9EAFC - READ | NOTIFY | DYNAMIC
+    0x1b, 0x00, 0x02, 0x00, 0x0d, 0x00, 0x03, 0x28, 0x12, 0x0e, 0x00, 0xfc, 0xea, 0xd9, 0xc8, 0xb7, 0xa6, 0x95, 0x84, 0x73, 0x62, 0x51, 0x40, 0x3f, 0x2e, 0x1d, 0x0c, 
+    // 0x000e VALUE CHARACTERISTIC-0C1D2E3F-4051-6273-8495-A6B7C8D9EAFC - READ | NOTIFY | DYNAMIC
+    // READ_ANYBODY
+    0x16, 0x00, 0x12, 0x03, 0x0e, 0x00, 0xfc, 0xea, 0xd9, 0xc8, 0xb7, 0xa6, 0x95, 0x84, 0x73, 0x62, 0x51, 0x40, 0x3f, 0x2e, 0x1d, 0x0c, 
+    // 0x000f CLIENT_CHARACTERISTIC_CONFIGURATION
+    // READ_ANYBODY, WRITE_ANYBODY
+    0x0a, 0x00, 0x0e, 0x01, 0x0f, 0x00, 0x02, 0x29, 0x00, 0x00, 
     // END
     0x00, 0x00, 
-}; // total size 112 bytes 
+}; // total size 244 bytes 
 
 
 //
@@ -72,9 +80,9 @@ static const uint8_t profile_data[] =
 #define ATT_SERVICE_GATT_SERVICE_01_START_HANDLE 0x0006
 #define ATT_SERVICE_GATT_SERVICE_01_END_HANDLE 0x0009
 #define ATT_SERVICE_21436587_A9CB_ED0F_1032_547698BADCFE_START_HANDLE 0x000a
-#define ATT_SERVICE_21436587_A9CB_ED0F_1032_547698BADCFE_END_HANDLE 0x000c
+#define ATT_SERVICE_21436587_A9CB_ED0F_1032_547698BADCFE_END_HANDLE 0x000f
 #define ATT_SERVICE_21436587_A9CB_ED0F_1032_547698BADCFE_01_START_HANDLE 0x000a
-#define ATT_SERVICE_21436587_A9CB_ED0F_1032_547698BADCFE_01_END_HANDLE 0x000c
+#define ATT_SERVICE_21436587_A9CB_ED0F_1032_547698BADCFE_01_END_HANDLE 0x000f
 
 //
 // list mapping between characteristics and handles
@@ -84,5 +92,7 @@ static const uint8_t profile_data[] =
 #define ATT_CHARACTERISTIC_GATT_SERVICE_CHANGED_01_VALUE_HANDLE 0x0008
 #define ATT_CHARACTERISTIC_GATT_SERVICE_CHANGED_01_CLIENT_CONFIGURATION_HANDLE 0x0009
 #define ATT_CHARACTERISTIC_0C1D2E3F_4051_6273_8495_A6B7C8D9EAFB_01_VALUE_HANDLE 0x000c
+#define ATT_CHARACTERISTIC_0C1D2E3F_4051_6273_8495_A6B7C8D9EAFC_01_VALUE_HANDLE 0x000e
+#define ATT_CHARACTERISTIC_0C1D2E3F_4051_6273_8495_A6B7C8D9EAFC_01_CLIENT_CONFIGURATION_HANDLE 0x000f
 
 #endif // PSL_MOTION_GATT_H
@@ -0,0 +1,537 @@
+#include "renderer.h"
+
+#include <math.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+
+#include "color.h"
+#include "frame_protocol.h"
+#include "latency_trace.h"
+#include "log_ring.h"
+#include "motion_protocol.h"
+#include "pixel_pack.h"
+#include "run_list.h"
+#include "strip_config.h"
+#include "ws2812_output.h"
+
+#define MIN_BRIGHTNESS_NORMALIZED 0.05f
+#define MAX_BRIGHTNESS_NORMALIZED 1.0f
+
+#ifndef PSL_RENDER_FPS
+#define PSL_RENDER_FPS 120
+#endif
+#define RENDER_FRAME_PERIOD_US (1000000u / PSL_RENDER_FPS)
+
+#ifndef PSL_ENABLE_DITHER
+#define PSL_ENABLE_DITHER 0
+#endif
+/* How often to check for a free back buffer while dithering. */
+#define DITHER_POLL_US 250u
+
+#define RENDERER_DOORBELL 0x50534c31u
+#define RENDERER_UPLOAD_COUNT 2u
+
+_Static_assert(!PSL_RUN_LIST_OUTPUT || !PSL_ENABLE_DITHER, "dithering needs per-pixel state");
+static command_queue_t command_queue;
+static uint8_t upload_buffers[RENDERER_UPLOAD_COUNT][RENDERER_UPLOAD_BYTES];
+static uint8_t upload_busy[RENDERER_UPLOAD_COUNT];
+
+/* Loaded by renderer_launch() before core1 starts; fixed until reboot. */
+static strip_config_t strip_config;
+static uint16_t led_count;
+
+/* Lighting state, owned by core1. */
+static uint16_t segment_start = 0;
+static uint16_t segment_end = 0;
+static float current_hue = 25.0f;
+static float current_saturation = 1.0f;
+static float current_brightness = 125.0f / 255.0f;
+static float hue_offset = 0.0f;
+static float brightness_offset = 0.0f;
+
+/*
+ * Full-brightness colours; brightness and gamma are applied when packing.
+ * Sized for the largest strip this build drives; the first led_count are
+ * in use.
+ */
+#if PSL_RUN_LIST_OUTPUT
+/* As runs of color_rgb_to_grb() values, so RAM does not scale with the LED count. */
+static run_list_t scene;
+#else
+static color_rgb_t pixels[WS2812_MAX_LEDS];
+#endif
+
+#if PSL_ENABLE_DITHER
+static color_rgb16_t linear_pixels[WS2812_MAX_LEDS];
+static pixel_dither_error_t dither_error[WS2812_MAX_LEDS];
+#endif
+
+static bool render_dirty = false;
+static bool pixels_dirty = true;
+static bool brightness_dirty = true;
+/* pixels[] was written directly by 0xA0 frame runs. */
+static bool frame_pixels_dirty = false;
+/* Showing an app-supplied frame rather than the hue/segment state. */
+static bool frame_mode = false;
+static volatile uint32_t stats_requested = 0;
+static volatile uint32_t stats_coalesced = 0;
+static volatile uint32_t stats_rendered = 0;
+static volatile uint32_t stats_render_us = 0;
+static volatile uint32_t stats_render_us_max = 0;
+
+static inline float clampf(float value, float min, float max) {
+    if (value < min) {
+        return min;
+    }
+    if (value > max) {
+        return max;
+    }
+    return value;
+}
+
+static void ws2812_init(void) {
+    ws2812_strip_t strips[WS2812_MAX_STRIPS];
+    for (uint i = 0; i < strip_config.chain_count; ++i) {
+        strips[i].pin = strip_config.pins[i];
+        strips[i].led_count = strip_config.chain_leds[i];
+    }
+    pixel_pack_set_order((pixel_order_t)strip_config.color_order);
+    if (!ws2812_output_init(strips, strip_config.chain_count)) {
+        PSL_LOG_ERROR("WS2812 output init failed\n");
+    }
+}
+
+static void render_pixels_from_state(void) {
+    float adjusted_hue = fmodf(current_hue + hue_offset, 360.0f);
+    if (adjusted_hue < 0.0f) {
+        adjusted_hue += 360.0f;
+    }
+    const color_rgb_t off = {0, 0, 0};
+    const color_rgb_t rgb = color_hsv16_to_rgb(color_hue16_from_degrees(adjusted_hue),
+                                               color_unit_to_u8(current_saturation), 255);
+#if PSL_RUN_LIST_OUTPUT
+    run_list_reset(&scene, led_count, color_rgb_to_grb(off));
+    run_list_paint(&scene, segment_start, (uint16_t)(segment_end - segment_start + 1u), color_rgb_to_grb(rgb));
+#else
+    for (uint i = 0; i < led_count; ++i) {
+        pixels[i] = (i >= segment_start && i <= segment_end) ? rgb : off;
+    }
+#endif
+}
+
+#if PSL_RUN_LIST_OUTPUT
+static bool paint_scene(uint16_t start, uint16_t count, color_rgb_t rgb) {
+    if (!run_list_paint(&scene, start, count, color_rgb_to_grb(rgb))) {
+        PSL_LOG_WARN("renderer: more than %u runs, LEDs from %u dropped\n", RUN_LIST_MAX_RUNS, start);
+        return false;
+    }
+    return true;
+}
+
+/* An 0xA5 pixel frame, painted a run of equal neighbours at a time. */
+static void paint_scene_pixels(uint16_t start, const uint8_t *rgb, uint16_t count) {
+    if (start >= led_count) {
+        return;
+    }
+    if (count > led_count - start) {
+        count = (uint16_t)(led_count - start);
+    }
+    uint16_t i = 0;
+    while (i < count) {
+        const uint8_t *p = rgb + i * 3u;
+        uint16_t n = 1;
+        while (i + n < count && memcmp(p + n * 3u, p, 3) == 0) {
+            n++;
+        }
+        const color_rgb_t color = {.r = p[0], .g = p[1], .b = p[2]};
+        if (!paint_scene((uint16_t)(start + i), n, color)) {
+            return;
+        }
+        i = (uint16_t)(i + n);
+    }
+}
+
+/* The back run list: the scene's runs with brightness and gamma applied. */
+static void pack_scene(run_list_t *out) {
+    out->length = scene.length;
+    out->count = scene.count;
+    for (uint16_t i = 0; i < scene.count; ++i) {
+        const uint32_t grb = scene.runs[i].value;
+        const color_rgb_t rgb = {
+            .r = (uint8_t)(grb >> 8),
+            .g = (uint8_t)(grb >> 16),
+            .b = (uint8_t)grb,
+        };
+        out->runs[i].start = scene.runs[i].start;
+        pixel_pack_grb(&out->runs[i].value, &rgb, 1);
+    }
+}
+#endif
+
+static void apply_brightness_from_state(void) {
+    if (frame_mode) {
+        /* The app bakes brightness into the frame colours. */
+        pixel_pack_set_brightness(255);
+        return;
+    }
+    float adjusted_brightness = clampf(
+        current_brightness + brightness_offset,
+        MIN_BRIGHTNESS_NORMALIZED,
+        MAX_BRIGHTNESS_NORMALIZED
+    );
+    pixel_pack_set_brightness(color_unit_to_u8(adjusted_brightness));
+}
+
+static void render_frame(void) {
+    uint32_t start_us = time_us_32();
+    latency_trace_render_begin();
+    bool relinearize = pixels_dirty || brightness_dirty || frame_pixels_dirty;
+    frame_pixels_dirty = false;
+    if (pixels_dirty) {
+        render_pixels_from_state();
+        pixels_dirty = false;
+    }
+    if (brightness_dirty) {
+        apply_brightness_from_state();
+        brightness_dirty = false;
+    }
+#if PSL_RUN_LIST_OUTPUT
+    (void)relinearize;
+    pack_scene(ws2812_output_begin_runs());
+#elif PSL_ENABLE_DITHER
+    if (relinearize) {
+        pixel_pack_linearize(linear_pixels, pixels, led_count);
+    }
+    pixel_pack_grb_dithered(ws2812_output_begin_frame(), linear_pixels, dither_error, led_count);
+#else
+    (void)relinearize;
+    pixel_pack_grb(ws2812_output_begin_frame(), pixels, led_count);
+#endif
+    ws2812_output_commit_frame();
+
+    uint32_t elapsed_us = time_us_32() - start_us;
+    stats_render_us = elapsed_us;
+    if (elapsed_us > stats_render_us_max) {
+        stats_render_us_max = elapsed_us;
+    }
+}
+
+static void clamp_segment_bounds(void) {
+    if (segment_start >= led_count) {
+        segment_start = led_count - 1;
+    }
+    if (segment_end >= led_count) {
+        segment_end = led_count - 1;
+    }
+    if (segment_start > segment_end) {
+        segment_end = segment_start;
+    }
+}
+
+static void set_segment_start(uint32_t start) {
+    uint32_t index = start;
+    if (index >= led_count) {
+        index = led_count - 1;
+    }
+    segment_start = (uint16_t)index;
+    clamp_segment_bounds();
+}
+
+static void set_segment_end(uint32_t end) {
+    uint32_t index = end;
+    if (index >= led_count) {
+        index = led_count - 1;
+    }
+    segment_end = (uint16_t)index;
+    clamp_segment_bounds();
+}
+
+static void set_hue(float degrees) {
+    float normalized = fmodf(degrees, 360.0f);
+    if (normalized < 0.0f) {
+        normalized += 360.0f;
+    }
+    current_hue = normalized;
+    hue_offset = 0.0f;
+}
+
+static void set_brightness(float percent) {
+    float normalized = percent / 100.0f;
+    current_brightness = clampf(
+        normalized,
+        MIN_BRIGHTNESS_NORMALIZED,
+        MAX_BRIGHTNESS_NORMALIZED
+    );
+    brightness_offset = 0.0f;
+}
+
+static void render_motion_color(float pitch, float roll, float yaw) {
+    const motion_color_t color = motion_color_from_angles(pitch, roll, yaw);
+    current_hue = color.hue;
+    current_saturation = color.saturation;
+    current_brightness = clampf(color.brightness, MIN_BRIGHTNESS_NORMALIZED, MAX_BRIGHTNESS_NORMALIZED);
+}
+
+static void adjust_hue(float delta) {
+    hue_offset = fmodf(hue_offset + delta, 360.0f);
+    if (hue_offset < 0.0f) {
+        hue_offset += 360.0f;
+    }
+}
+
+static void adjust_brightness(float delta) {
+    float desired = clampf(
+        current_brightness + brightness_offset + delta,
+        MIN_BRIGHTNESS_NORMALIZED,
+        MAX_BRIGHTNESS_NORMALIZED
+    );
+    brightness_offset = desired - current_brightness;
+}
+
+static void leave_frame_mode(void) {
+    if (frame_mode) {
+        frame_mode = false;
+        pixels_dirty = true;
+        brightness_dirty = true;
+    }
+}
+
+/*
+ * Frame runs and uploads paint over pixels[] in place, so state commands
+ * still waiting for a render must land first; otherwise render_frame()
+ * would repaint the state over the frame.
+ */
+static void flush_pending_state(void) {
+    if (pixels_dirty) {
+        render_pixels_from_state();
+        pixels_dirty = false;
+    }
+}
+
+static void apply_command(const psl_command_t *command) {
+    if (command->type == PSL_CMD_FRAME_RUN) {
+        flush_pending_state();
+        /* Runs are part of the frame their commit completes; not counted alone. */
+#if PSL_RUN_LIST_OUTPUT
+        paint_scene(command->u.run.start, command->u.run.length, command->u.run.color);
+#else
+        frame_apply_run(pixels, led_count, &command->u.run);
+#endif
+        frame_pixels_dirty = true;
+        return;
+    }
+    if (command->type == PSL_CMD_FRAME_PIXELS) {
+        const frame_pixels_t *upload = &command->u.pixels;
+        flush_pending_state();
+#if PSL_RUN_LIST_OUTPUT
+        paint_scene_pixels(upload->start, upload->rgb, upload->count);
+#else
+        frame_apply_pixels(pixels, led_count, upload->start, upload->rgb, upload->count);
+#endif
+        renderer_upload_release(upload->rgb);
+        frame_pixels_dirty = true;
+        return;
+    }
+    if (command->type != PSL_CMD_FRAME_COMMIT) {
+        leave_frame_mode();
+    }
+    switch (command->type) {
+    case PSL_CMD_SET_HUE:
+        set_hue(command->u.value);
+        pixels_dirty = true;
+        break;
+    case PSL_CMD_SET_BRIGHTNESS:
+        set_brightness(command->u.value);
+        brightness_dirty = true;
+        break;
+    case PSL_CMD_ADJUST_HUE:
+        adjust_hue(command->u.value);
+        pixels_dirty = true;
+        break;
+    case PSL_CMD_ADJUST_BRIGHTNESS:
+        adjust_brightness(command->u.value);
+        brightness_dirty = true;
+        break;
+    case PSL_CMD_SEGMENT_START:
+        set_segment_start(command->u.index);
+        pixels_dirty = true;
+        break;
+    case PSL_CMD_SEGMENT_END:
+        set_segment_end(command->u.index);
+        pixels_dirty = true;
+        break;
+    case PSL_CMD_MOTION:
+        render_motion_color(command->u.motion.pitch, command->u.motion.roll, command->u.motion.yaw);
+        pixels_dirty = true;
+        brightness_dirty = true;
+        break;
+    case PSL_CMD_FRAME_COMMIT:
+        flush_pending_state();
+        if (!frame_mode) {
+            frame_mode = true;
+            brightness_dirty = true;
+        }
+        break;
+    default:
+        return;
+    }
+    stats_requested++;
+    if (render_dirty) {
+        stats_coalesced++;
+    }
+    render_dirty = true;
+}
+
+static void drain_command_queue(void) {
+    psl_command_t command;
+    latency_trace_claim_write();
+    while (command_queue_pop(&command_queue, &command)) {
+        apply_command(&command);
+    }
+}
+
+static void wait_for_doorbell(absolute_time_t deadline) {
+    uint32_t doorbell;
+    if (is_at_the_end_of_time(deadline)) {
+        doorbell = multicore_fifo_pop_blocking();
+    } else {
+        int64_t wait_us = absolute_time_diff_us(get_absolute_time(), deadline);
+        if (wait_us <= 0 || !multicore_fifo_pop_timeout_us((uint64_t)wait_us, &doorbell)) {
+            return;
+        }
+    }
+    (void)doorbell;
+    multicore_fifo_drain();
+}
+
+#if PSL_ENABLE_DITHER
+/*
+ * Dithering only works if the strip keeps refreshing, so pack a new frame
+ * every time the back buffer frees up instead of waiting for commands. The
+ * refresh rate is whatever the chain length allows (~100 Hz at 300 LEDs).
+ */
+static void renderer_dither_loop(void) {
+    for (;;) {
+        drain_command_queue();
+        if (ws2812_output_commit_pending()) {
+            wait_for_doorbell(make_timeout_time_us(DITHER_POLL_US));
+            continue;
+        }
+        if (render_dirty) {
+            render_dirty = false;
+            stats_rendered++;
+        }
+        render_frame();
+        /* An unchanged frame is not sent; don't spin re-packing it. */
+        if (!ws2812_output_busy()) {
+            wait_for_doorbell(make_timeout_time_us(DITHER_POLL_US));
+        }
+    }
+}
+#else
+static void renderer_frame_loop(void) {
+    absolute_time_t next_frame = get_absolute_time();
+    for (;;) {
+        drain_command_queue();
+        if (!render_dirty) {
+            wait_for_doorbell(at_the_end_of_time);
+            continue;
+        }
+        if (!time_reached(next_frame)) {
+            wait_for_doorbell(next_frame);
+            continue;
+        }
+        render_dirty = false;
+        next_frame = make_timeout_time_us(RENDER_FRAME_PERIOD_US);
+        render_frame();
+        stats_rendered++;
+    }
+}
+#endif
+
+static void renderer_core1_entry(void) {
+    ws2812_init();
+#if PSL_ENABLE_DITHER
+    pixel_pack_dither_reset(dither_error, led_count);
+#endif
+    render_frame();
+
+#if PSL_ENABLE_DITHER
+    renderer_dither_loop();
+#else
+    renderer_frame_loop();
+#endif
+}
+
+void renderer_launch(void) {
+    bool stored = strip_config_load(&strip_config);
+    led_count = strip_config.led_count;
+    segment_end = (uint16_t)(led_count - 1u);
+    PSL_LOG_INFO("renderer: %u LEDs, %s, %u chain(s) (%s)\n", led_count,
+                 strip_config_order_name(strip_config.color_order), strip_config.chain_count,
+                 stored ? "stored config" : "defaults");
+    command_queue_init(&command_queue);
+    multicore_launch_core1(renderer_core1_entry);
+}
+
+void renderer_stop(void) {
+    multicore_reset_core1();
+}
+
+bool renderer_post(const psl_command_t *command) {
+    if (!command_queue_push(&command_queue, command)) {
+        return false;
+    }
+    latency_trace_write_decoded();
+    if (multicore_fifo_wready()) {
+        multicore_fifo_push_blocking(RENDERER_DOORBELL);
+    }
+    return true;
+}
+
+bool renderer_stage(const psl_command_t *command) {
+    return command_queue_stage(&command_queue, command);
+}
+
+void renderer_publish(void) {
+    command_queue_publish(&command_queue);
+    latency_trace_write_decoded();
+    if (multicore_fifo_wready()) {
+        multicore_fifo_push_blocking(RENDERER_DOORBELL);
+    }
+}
+
+void renderer_discard(void) {
+    command_queue_discard_staged(&command_queue);
+}
+
+uint8_t *renderer_upload_acquire(void) {
+    for (uint i = 0; i < RENDERER_UPLOAD_COUNT; ++i) {
+        if (!__atomic_load_n(&upload_busy[i], __ATOMIC_ACQUIRE)) {
+            upload_busy[i] = 1;
+            return upload_buffers[i];
+        }
+    }
+    return NULL;
+}
+
+/* Accepts any pointer into a buffer, not just its start. */
+void renderer_upload_release(const uint8_t *buffer) {
+    uint32_t index = (uint32_t)(buffer - &upload_buffers[0][0]) / RENDERER_UPLOAD_BYTES;
+    if (index < RENDERER_UPLOAD_COUNT) {
+        __atomic_store_n(&upload_busy[index], 0, __ATOMIC_RELEASE);
+    }
+}
+
+void renderer_get_stats(render_stats_t *stats) {
+    stats->requested = stats_requested;
+    stats->coalesced = stats_coalesced;
+    stats->rendered = stats_rendered;
+    stats->dropped = command_queue.dropped;
+    stats->queue_depth = command_queue_depth(&command_queue);
+    stats->frames_out = ws2812_output_frames_sent();
+    stats->frames_unchanged = ws2812_output_frames_unchanged();
+    stats->render_us = stats_render_us;
+    stats->render_us_max = stats_render_us_max;
+}
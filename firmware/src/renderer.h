@@ -0,0 +1,61 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "command_queue.h"
+#include "ws2812_output.h"
+
+/*
+ * Core1 renderer. Core0 (BTstack + cyw43) decodes BLE writes into
+ * psl_command_t and posts them here; core1 owns the lighting state, renders
+ * at most once per frame period and drives the WS2812 output. Commands travel
+ * through an SPSC ring, the inter-core FIFO only carries doorbells.
+ */
+
+typedef struct {
+    uint32_t requested;
+    uint32_t coalesced;
+    uint32_t rendered;
+    uint32_t dropped;
+    uint32_t queue_depth;
+    uint32_t frames_out;
+    uint32_t frames_unchanged;
+    uint32_t render_us;
+    uint32_t render_us_max;
+} render_stats_t;
+
+/* Loads the strip config (strip_config.h) and starts core1 with it. */
+void renderer_launch(void);
+/* Halt core1 for good, e.g. before writing flash; the strip keeps its last
+ * frame. Only a reboot brings the renderer back. */
+void renderer_stop(void);
+bool renderer_post(const psl_command_t *command);
+
+/* Batch posting: stage any number of commands, then publish them to core1 in
+ * one step. A failed stage leaves the batch staged; call renderer_discard(). */
+bool renderer_stage(const psl_command_t *command);
+void renderer_publish(void);
+void renderer_discard(void);
+
+/*
+ * Upload buffers for bulk pixel data (reassembled 0xA5 frames). Core0
+ * acquires one, fills it and posts PSL_CMD_FRAME_PIXELS pointing into it;
+ * core1 copies the pixels out and releases it. Returns NULL if all are busy.
+ *
+ * Each holds a 0xA5 frame for the longest strip a CFG can set up, except
+ * with run-list output, whose strips are too long for that: there a frame
+ * covers at most RENDERER_UPLOAD_PIXELS LEDs, and longer strips take
+ * several frames at increasing start offsets.
+ */
+#if PSL_RUN_LIST_OUTPUT
+#define RENDERER_UPLOAD_PIXELS 340u
+#else
+#define RENDERER_UPLOAD_PIXELS WS2812_MAX_LEDS
+#endif
+#define RENDERER_UPLOAD_BYTES (PSL_FRAME_PIXELS_HEADER_LEN + RENDERER_UPLOAD_PIXELS * 3u)
+uint8_t *renderer_upload_acquire(void);
+void renderer_upload_release(const uint8_t *buffer);
+void renderer_get_stats(render_stats_t *stats);
+
+#endif
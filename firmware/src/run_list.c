@@ -0,0 +1,115 @@
+#include "run_list.h"
+
+#include <string.h>
+
+static inline uint32_t run_end(const run_list_t *list, uint16_t index) {
+    return index + 1u < list->count ? list->runs[index + 1u].start : list->length;
+}
+
+/* Index of the run covering position. */
+static uint16_t run_find(const run_list_t *list, uint16_t position) {
+    uint16_t lo = 0;
+    uint16_t hi = list->count;
+    while (lo + 1u < hi) {
+        uint16_t mid = (uint16_t)((lo + hi) / 2u);
+        if (list->runs[mid].start <= position) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void run_remove(run_list_t *list, uint16_t index) {
+    memmove(&list->runs[index], &list->runs[index + 1u], (size_t)(list->count - index - 1u) * sizeof(run_t));
+    list->count--;
+}
+
+void run_list_reset(run_list_t *list, uint16_t length, uint32_t value) {
+    list->length = length;
+    list->count = length ? 1u : 0u;
+    list->runs[0].start = 0;
+    list->runs[0].value = value;
+}
+
+bool run_list_paint(run_list_t *list, uint16_t start, uint16_t count, uint32_t value) {
+    if (start >= list->length || count == 0) {
+        return true;
+    }
+    uint32_t end = (uint32_t)start + count;
+    if (end > list->length) {
+        end = list->length;
+    }
+    const uint16_t first = run_find(list, start);
+    const uint16_t last = run_find(list, (uint16_t)(end - 1u));
+    const uint32_t tail_value = list->runs[last].value;
+    /* The runs cut at either end keep their outside part. */
+    const uint16_t head = (uint16_t)(first + (list->runs[first].start < start));
+    const uint16_t tail = run_end(list, last) > end ? 1u : 0u;
+    const uint16_t rest = (uint16_t)(list->count - last - 1u);
+    if (head + 1u + tail + rest > RUN_LIST_MAX_RUNS) {
+        return false;
+    }
+    memmove(&list->runs[head + 1u + tail], &list->runs[last + 1u], rest * sizeof(run_t));
+    list->runs[head].start = start;
+    list->runs[head].value = value;
+    if (tail) {
+        list->runs[head + 1u].start = (uint16_t)end;
+        list->runs[head + 1u].value = tail_value;
+    }
+    list->count = (uint16_t)(head + 1u + tail + rest);
+
+    if (head + 1u < list->count && list->runs[head + 1u].value == value) {
+        run_remove(list, (uint16_t)(head + 1u));
+    }
+    if (head > 0 && list->runs[head - 1u].value == value) {
+        run_remove(list, head);
+    }
+    return true;
+}
+
+void run_list_expand(const run_list_t *list, uint16_t position, uint32_t *out, uint16_t count) {
+    if (!count) {
+        return;
+    }
+    uint16_t index = run_find(list, position);
+    const uint32_t stop = (uint32_t)position + count;
+    uint32_t at = position;
+    while (at < stop) {
+        uint32_t end = run_end(list, index);
+        if (end > stop) {
+            end = stop;
+        }
+        const uint32_t value = list->runs[index].value;
+        for (; at < end; ++at) {
+            *out++ = value;
+        }
+        index++;
+    }
+}
+
+uint16_t run_list_last_difference(const run_list_t *a, const run_list_t *b, uint16_t from, uint16_t to) {
+    if (from >= to) {
+        return from;
+    }
+    uint16_t ia = run_find(a, from);
+    uint16_t ib = run_find(b, from);
+    uint32_t at = from;
+    uint16_t last = from;
+    while (at < to) {
+        const uint32_t end_a = run_end(a, ia);
+        const uint32_t end_b = run_end(b, ib);
+        uint32_t end = end_a < end_b ? end_a : end_b;
+        if (end > to) {
+            end = to;
+        }
+        if (a->runs[ia].value != b->runs[ib].value) {
+            last = (uint16_t)end;
+        }
+        ia = (uint16_t)(ia + (end == end_a));
+        ib = (uint16_t)(ib + (end == end_b));
+        at = end;
+    }
+    return last;
+}
@@ -0,0 +1,46 @@
+#ifndef RUN_LIST_H
+#define RUN_LIST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * A strip as a sorted list of runs of one value each, for output modes
+ * whose RAM should not grow with the LED count. Runs tile [0, length): each
+ * starts where the previous one ends, and the last one ends at length.
+ * Painting keeps neighbouring runs of equal value merged.
+ */
+
+#ifndef RUN_LIST_MAX_RUNS
+#define RUN_LIST_MAX_RUNS 128u
+#endif
+
+typedef struct {
+    uint16_t start;
+    uint32_t value;
+} run_t;
+
+typedef struct {
+    uint16_t length;
+    uint16_t count;
+    run_t runs[RUN_LIST_MAX_RUNS];
+} run_list_t;
+
+/* One run of `value` over the whole length. */
+void run_list_reset(run_list_t *list, uint16_t length, uint32_t value);
+
+/*
+ * Set [start, start + count) to value, clipped to the list length. Returns
+ * false, leaving the list unchanged, if the result needs more than
+ * RUN_LIST_MAX_RUNS runs.
+ */
+bool run_list_paint(run_list_t *list, uint16_t start, uint16_t count, uint32_t value);
+
+/* Expand `count` values from `position` on into out. */
+void run_list_expand(const run_list_t *list, uint16_t position, uint32_t *out, uint16_t count);
+
+/* One past the last index in [from, to) where the lists differ, or `from`
+ * if they agree there. Both lists must have the same length. */
+uint16_t run_list_last_difference(const run_list_t *a, const run_list_t *b, uint16_t from, uint16_t to);
+
+#endif
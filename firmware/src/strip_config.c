@@ -0,0 +1,179 @@
+#include "strip_config.h"
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+
+#include "log_ring.h"
+
+/* Default geometry: PSL_NUM_LEDS split evenly into one chain per pin. */
+#ifndef PSL_NUM_LEDS
+#define PSL_NUM_LEDS 300
+#endif
+#ifndef PSL_STRIP_PINS
+#define PSL_STRIP_PINS 0
+#endif
+
+/* The sector below the two BTstack keeps its bonding database in, at the
+ * end of flash. */
+#ifndef PSL_CONFIG_FLASH_OFFSET
+#define PSL_CONFIG_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - 3u * FLASH_SECTOR_SIZE)
+#endif
+
+#define STRIP_CONFIG_MAGIC 0x4346534cu /* "LSFC" */
+#define STRIP_CONFIG_VERSION 1u
+/* GPIOs in bank 0. */
+#define STRIP_CONFIG_GPIO_COUNT 30u
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    strip_config_t config;
+    uint32_t checksum;
+} strip_config_record_t;
+
+_Static_assert(sizeof(strip_config_record_t) <= FLASH_PAGE_SIZE, "config record must fit one flash page");
+
+static const uint8_t default_pins[] = {PSL_STRIP_PINS};
+#define DEFAULT_CHAIN_COUNT (sizeof(default_pins) / sizeof(default_pins[0]))
+_Static_assert(DEFAULT_CHAIN_COUNT <= WS2812_MAX_STRIPS, "too many PSL_STRIP_PINS");
+_Static_assert(PSL_NUM_LEDS <= WS2812_MAX_LEDS, "PSL_NUM_LEDS exceeds WS2812_MAX_LEDS");
+_Static_assert(!PSL_PARALLEL_OUTPUT ||
+                   (PSL_NUM_LEDS + DEFAULT_CHAIN_COUNT - 1) / DEFAULT_CHAIN_COUNT <= WS2812_PARALLEL_MAX_ROWS,
+               "PSL_NUM_LEDS over PSL_STRIP_PINS exceeds WS2812_PARALLEL_MAX_ROWS");
+
+#if PICO_CYW43_SUPPORTED
+/* Wired to the CYW43 (WL_ON, data, chip select, clock); a chain there
+ * would take the radio, and with it the only way to send another CFG. */
+static const uint8_t cyw43_pins[] = {23, 24, 25, 29};
+#endif
+
+static const char order_names[PIXEL_ORDER_COUNT][4] = {
+    [PIXEL_ORDER_GRB] = "GRB",
+    [PIXEL_ORDER_RGB] = "RGB",
+    [PIXEL_ORDER_BRG] = "BRG",
+    [PIXEL_ORDER_RBG] = "RBG",
+    [PIXEL_ORDER_GBR] = "GBR",
+    [PIXEL_ORDER_BGR] = "BGR",
+};
+
+/* FNV-1a; enough to tell a record from erased or foreign bytes. */
+static uint32_t checksum(const void *data, size_t len) {
+    const uint8_t *p = data;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static bool pin_reserved(uint8_t pin) {
+#if PICO_CYW43_SUPPORTED
+    for (uint i = 0; i < sizeof(cyw43_pins); ++i) {
+        if (cyw43_pins[i] == pin) {
+            return true;
+        }
+    }
+#endif
+    (void)pin;
+    return false;
+}
+
+void strip_config_defaults(strip_config_t *config) {
+    memset(config, 0, sizeof(*config));
+    config->led_count = PSL_NUM_LEDS;
+    config->color_order = PIXEL_ORDER_GRB;
+    config->chain_count = DEFAULT_CHAIN_COUNT;
+    for (uint i = 0; i < DEFAULT_CHAIN_COUNT; ++i) {
+        config->pins[i] = default_pins[i];
+        config->chain_leds[i] =
+            (uint16_t)((i + 1u) * PSL_NUM_LEDS / DEFAULT_CHAIN_COUNT - i * PSL_NUM_LEDS / DEFAULT_CHAIN_COUNT);
+    }
+}
+
+bool strip_config_validate(strip_config_t *config) {
+    uint max_chains = ws2812_output_max_strips();
+    if (config->chain_count == 0 || config->chain_count > max_chains) {
+        PSL_LOG_WARN("config: %u chains, 1..%u supported\n", config->chain_count, max_chains);
+        return false;
+    }
+    if (config->color_order >= PIXEL_ORDER_COUNT) {
+        PSL_LOG_WARN("config: unknown colour order %u\n", config->color_order);
+        return false;
+    }
+    uint32_t total = 0;
+    for (uint i = 0; i < config->chain_count; ++i) {
+        if (config->pins[i] >= STRIP_CONFIG_GPIO_COUNT || config->chain_leds[i] == 0) {
+            PSL_LOG_WARN("config: chain %u on GPIO %u with %u LEDs\n", i, config->pins[i], config->chain_leds[i]);
+            return false;
+        }
+        for (uint j = 0; j < i; ++j) {
+            if (config->pins[j] == config->pins[i]) {
+                PSL_LOG_WARN("config: GPIO %u used twice\n", config->pins[i]);
+                return false;
+            }
+        }
+        if (pin_reserved(config->pins[i])) {
+            PSL_LOG_WARN("config: GPIO %u belongs to the radio\n", config->pins[i]);
+            return false;
+        }
+#if PSL_PARALLEL_OUTPUT
+        if (config->pins[i] != config->pins[0] + i) {
+            PSL_LOG_WARN("config: parallel output needs consecutive pins\n");
+            return false;
+        }
+        if (config->chain_leds[i] > WS2812_PARALLEL_MAX_ROWS) {
+            PSL_LOG_WARN("config: chain of %u LEDs, parallel output supports %u\n", config->chain_leds[i],
+                         WS2812_PARALLEL_MAX_ROWS);
+            return false;
+        }
+#endif
+        total += config->chain_leds[i];
+    }
+    if (total > WS2812_MAX_LEDS) {
+        PSL_LOG_WARN("config: %lu LEDs, this build holds %u\n", (unsigned long)total, WS2812_MAX_LEDS);
+        return false;
+    }
+    config->led_count = (uint16_t)total;
+    return true;
+}
+
+bool strip_config_load(strip_config_t *config) {
+    strip_config_record_t record;
+    memcpy(&record, (const void *)(XIP_BASE + PSL_CONFIG_FLASH_OFFSET), sizeof(record));
+    if (record.magic == STRIP_CONFIG_MAGIC && record.version == STRIP_CONFIG_VERSION &&
+        record.size == sizeof(record.config) && record.checksum == checksum(&record.config, sizeof(record.config))) {
+        *config = record.config;
+        if (strip_config_validate(config)) {
+            return true;
+        }
+    }
+    strip_config_defaults(config);
+    return false;
+}
+
+bool strip_config_save(const strip_config_t *config) {
+    static uint8_t page[FLASH_PAGE_SIZE];
+    strip_config_record_t record;
+    memset(&record, 0, sizeof(record));
+    record.magic = STRIP_CONFIG_MAGIC;
+    record.version = STRIP_CONFIG_VERSION;
+    record.size = sizeof(record.config);
+    record.config = *config;
+    record.checksum = checksum(&record.config, sizeof(record.config));
+    memset(page, 0xff, sizeof(page));
+    memcpy(page, &record, sizeof(record));
+
+    uint32_t interrupts = save_and_disable_interrupts();
+    flash_range_erase(PSL_CONFIG_FLASH_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(PSL_CONFIG_FLASH_OFFSET, page, FLASH_PAGE_SIZE);
+    restore_interrupts(interrupts);
+
+    return memcmp((const void *)(XIP_BASE + PSL_CONFIG_FLASH_OFFSET), page, sizeof(record)) == 0;
+}
+
+const char *strip_config_order_name(uint8_t order) {
+    return order < PIXEL_ORDER_COUNT ? order_names[order] : "?";
+}
@@ -0,0 +1,46 @@
+#ifndef STRIP_CONFIG_H
+#define STRIP_CONFIG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pixel_pack.h"
+#include "ws2812_output.h"
+
+/*
+ * Strip geometry chosen at runtime: total LED count, wire colour order and
+ * the chains it is split into, each with its pin and length. It lives in a
+ * flash sector so one image serves every fixture; the renderer loads it
+ * once at boot and sizes nothing by it, all pixel state comes from arenas
+ * of WS2812_MAX_LEDS. Without a valid record the compile-time PSL_NUM_LEDS
+ * split evenly over PSL_STRIP_PINS applies.
+ */
+
+typedef struct {
+    uint16_t led_count;   /* sum of chain_leds[] */
+    uint8_t color_order;  /* pixel_order_t */
+    uint8_t chain_count;
+    uint8_t pins[WS2812_MAX_STRIPS];
+    uint16_t chain_leds[WS2812_MAX_STRIPS];
+} strip_config_t;
+
+void strip_config_defaults(strip_config_t *config);
+
+/* Checks a config against what this build's output engine can drive; logs
+ * the first problem. Fills in led_count from the chains. */
+bool strip_config_validate(strip_config_t *config);
+
+/* The stored config, or the defaults if flash holds none (or a bad one).
+ * Returns true if it came from flash. */
+bool strip_config_load(strip_config_t *config);
+
+/*
+ * Erase the config sector and write config to it. Nothing may run from
+ * flash meanwhile: core1 must be stopped, and interrupts on this core are
+ * disabled for the ~50 ms it takes. Meant to be followed by a reboot.
+ */
+bool strip_config_save(const strip_config_t *config);
+
+/* "GRB", "RGB", ... */
+const char *strip_config_order_name(uint8_t order);
+
+#endif
@@ -0,0 +1,188 @@
+#include "telemetry.h"
+
+#ifndef PSL_HOST_BUILD
+#define PSL_HOST_BUILD 0
+#endif
+
+#if !PSL_HOST_BUILD
+#include <malloc.h>
+#include "hardware/sync.h"
+#endif
+#include <stdbool.h>
+#include "btstack_util.h"
+#include "ble/att_db.h"
+#include "ble/att_server.h"
+
+#include "ble_link.h"
+#include "log_ring.h"
+#include "renderer.h"
+
+#define STACK_WATERMARK 0x5053574du
+/* Leave the live part of core0's stack (and a margin below it) alone. */
+#define STACK_PAINT_MARGIN 256u
+
+static uint16_t telemetry_value_handle;
+static uint32_t (*telemetry_packet_drops)(void);
+static hci_con_handle_t notify_handle = HCI_CON_HANDLE_INVALID;
+static btstack_timer_source_t telemetry_timer;
+static uint8_t sample[TELEMETRY_SAMPLE_LEN];
+
+static uint32_t last_sample_ms;
+static uint32_t last_rendered;
+static uint32_t last_frames_out;
+static uint32_t last_writes;
+static uint32_t last_bytes;
+
+#if PSL_HOST_BUILD
+/* The host simulation has no linker-script stacks or newlib heap. */
+void telemetry_paint_stacks(void) {}
+
+static uint32_t free_heap_bytes(void) {
+    return 0;
+}
+
+static uint16_t core0_stack_headroom(void) {
+    return 0;
+}
+
+static uint16_t core1_stack_headroom(void) {
+    return 0;
+}
+#else
+/* Provided by the pico-sdk linker script. */
+extern uint32_t __StackBottom;
+extern uint32_t __StackTop;
+extern uint32_t __StackOneBottom;
+extern uint32_t __StackOneTop;
+extern char __StackLimit;
+extern char __bss_end__;
+
+static void paint_stack(uint32_t *bottom, const uint32_t *top) {
+    for (uint32_t *word = bottom; word < top; ++word) {
+        *word = STACK_WATERMARK;
+    }
+}
+
+static uint16_t stack_headroom(const uint32_t *bottom, const uint32_t *top) {
+    const uint32_t *word = bottom;
+    while (word < top && *word == STACK_WATERMARK) {
+        ++word;
+    }
+    uint32_t bytes = (uint32_t)(word - bottom) * sizeof(uint32_t);
+    return (uint16_t)(bytes > UINT16_MAX ? UINT16_MAX : bytes);
+}
+
+void telemetry_paint_stacks(void) {
+    /* USB and cyw43 interrupts are live by now; a handler stacked past the
+     * margin would have its frame painted over. */
+    uint32_t interrupts = save_and_disable_interrupts();
+    uint32_t here;
+    uint32_t *live = (uint32_t *)((uintptr_t)&here - STACK_PAINT_MARGIN);
+    paint_stack(&__StackBottom, live);
+    paint_stack(&__StackOneBottom, &__StackOneTop);
+    restore_interrupts(interrupts);
+}
+
+static uint32_t free_heap_bytes(void) {
+    struct mallinfo info = mallinfo();
+    uint32_t total = (uint32_t)(&__StackLimit - &__bss_end__);
+    return total > (uint32_t)info.uordblks ? total - (uint32_t)info.uordblks : 0;
+}
+
+static uint16_t core0_stack_headroom(void) {
+    return stack_headroom(&__StackBottom, &__StackTop);
+}
+
+static uint16_t core1_stack_headroom(void) {
+    return stack_headroom(&__StackOneBottom, &__StackOneTop);
+}
+#endif
+
+static uint16_t clamp_u16(uint32_t value) {
+    return (uint16_t)(value > UINT16_MAX ? UINT16_MAX : value);
+}
+
+/* count per second over elapsed_ms, times scale. */
+static uint32_t rate(uint32_t count, uint32_t elapsed_ms, uint32_t scale) {
+    return elapsed_ms ? (uint32_t)(((uint64_t)count * 1000u * scale) / elapsed_ms) : 0;
+}
+
+static void build_sample(void) {
+    render_stats_t stats;
+    renderer_get_stats(&stats);
+    const ble_link_state_t *link = ble_link_state();
+    uint32_t now_ms = btstack_run_loop_get_time_ms();
+    uint32_t elapsed_ms = now_ms - last_sample_ms;
+    uint32_t dropped = stats.dropped + (telemetry_packet_drops ? telemetry_packet_drops() : 0);
+
+    sample[0] = TELEMETRY_VERSION;
+    sample[1] = link->streaming ? 0x01u : 0x00u;
+    little_endian_store_16(sample, 2, clamp_u16(rate(stats.rendered - last_rendered, elapsed_ms, 10)));
+    little_endian_store_16(sample, 4, clamp_u16(rate(stats.frames_out - last_frames_out, elapsed_ms, 10)));
+    little_endian_store_16(sample, 6, clamp_u16(stats.queue_depth));
+    little_endian_store_32(sample, 8, stats.coalesced);
+    little_endian_store_32(sample, 12, dropped);
+    little_endian_store_16(sample, 16, clamp_u16(stats.render_us));
+    little_endian_store_16(sample, 18, clamp_u16(stats.render_us_max));
+    little_endian_store_16(sample, 20, clamp_u16(rate(link->rx_writes - last_writes, elapsed_ms, 1)));
+    little_endian_store_32(sample, 22, rate(link->rx_bytes - last_bytes, elapsed_ms, 1));
+    little_endian_store_16(sample, 26, link->handle == HCI_CON_HANDLE_INVALID ? 0 : link->interval);
+    little_endian_store_32(sample, 28, free_heap_bytes());
+    little_endian_store_16(sample, 32, core0_stack_headroom());
+    little_endian_store_16(sample, 34, core1_stack_headroom());
+
+    last_sample_ms = now_ms;
+    last_rendered = stats.rendered;
+    last_frames_out = stats.frames_out;
+    last_writes = link->rx_writes;
+    last_bytes = link->rx_bytes;
+}
+
+static void telemetry_timer_handler(btstack_timer_source_t *ts) {
+    if (notify_handle == HCI_CON_HANDLE_INVALID) {
+        return;
+    }
+    if (ble_link_state()->mtu >= TELEMETRY_SAMPLE_LEN + 3u) {
+        build_sample();
+        /* Skipped if the ACL buffers are busy; the next period catches up. */
+        att_server_notify(notify_handle, telemetry_value_handle, sample, TELEMETRY_SAMPLE_LEN);
+    }
+    btstack_run_loop_set_timer(ts, TELEMETRY_PERIOD_MS);
+    btstack_run_loop_add_timer(ts);
+}
+
+void telemetry_init(uint16_t value_handle, uint32_t (*packet_drops)(void)) {
+    telemetry_value_handle = value_handle;
+    telemetry_packet_drops = packet_drops;
+    btstack_run_loop_set_timer_handler(&telemetry_timer, &telemetry_timer_handler);
+}
+
+uint16_t telemetry_read(uint16_t offset, uint8_t *buffer, uint16_t buffer_size) {
+    if (buffer && offset == 0) {
+        build_sample();
+    }
+    return att_read_callback_handle_blob(sample, TELEMETRY_SAMPLE_LEN, offset, buffer, buffer_size);
+}
+
+int telemetry_write_client_config(hci_con_handle_t con_handle, const uint8_t *buffer, uint16_t buffer_size) {
+    if (buffer_size != 2) {
+        return ATT_ERROR_INVALID_ATTRIBUTE_VALUE_LENGTH;
+    }
+    bool enable = (little_endian_read_16(buffer, 0) & GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION) != 0;
+    btstack_run_loop_remove_timer(&telemetry_timer);
+    if (!enable) {
+        notify_handle = HCI_CON_HANDLE_INVALID;
+        return 0;
+    }
+    notify_handle = con_handle;
+    build_sample();
+    btstack_run_loop_set_timer(&telemetry_timer, TELEMETRY_PERIOD_MS);
+    btstack_run_loop_add_timer(&telemetry_timer);
+    PSL_LOG_INFO("Telemetry notifications enabled on 0x%04x\n", con_handle);
+    return 0;
+}
+
+void telemetry_disconnected(void) {
+    btstack_run_loop_remove_timer(&telemetry_timer);
+    notify_handle = HCI_CON_HANDLE_INVALID;
+}
@@ -0,0 +1,50 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include "btstack.h"
+
+/*
+ * Telemetry characteristic (0C1D2E3F-...-A6B7C8D9EAFC, READ | NOTIFY). Once a
+ * client enables notifications, a sample is pushed every TELEMETRY_PERIOD_MS
+ * so it can pace its writes to what the device keeps up with. All fields are
+ * little endian; rates are over the last period, counters are cumulative.
+ *
+ *   off  size  field
+ *     0     1  version (TELEMETRY_VERSION)
+ *     1     1  flags: bit0 link in streaming (fast interval) mode
+ *     2     2  rendered frames/s x10
+ *     4     2  output frames/s x10 (strip refreshes)
+ *     6     2  command queue depth
+ *     8     4  coalesced commands
+ *    12     4  dropped packets (queue full, bad/abandoned frames)
+ *    16     2  last render time, us
+ *    18     2  max render time, us
+ *    20     2  BLE writes/s
+ *    22     4  BLE write bytes/s
+ *    26     2  connection interval, 1.25 ms units (0 = disconnected)
+ *    28     4  free heap, bytes
+ *    32     2  core0 stack headroom, bytes
+ *    34     2  core1 stack headroom, bytes
+ */
+
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_SAMPLE_LEN 36u
+#define TELEMETRY_PERIOD_MS 1000u
+
+/* Fill both cores' stacks with a watermark, interrupts off meanwhile; call
+ * before launching core1. */
+void telemetry_paint_stacks(void);
+
+/* packet_drops reports protocol-level drops counted outside the renderer. */
+void telemetry_init(uint16_t value_handle, uint32_t (*packet_drops)(void));
+
+/* ATT read of the value handle (also answers the size query with NULL). */
+uint16_t telemetry_read(uint16_t offset, uint8_t *buffer, uint16_t buffer_size);
+
+/* ATT write of the client configuration descriptor. */
+int telemetry_write_client_config(hci_con_handle_t con_handle, const uint8_t *buffer, uint16_t buffer_size);
+
+void telemetry_disconnected(void);
+
+#endif
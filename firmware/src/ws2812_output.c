@@ -0,0 +1,513 @@
+#include "ws2812_output.h"
+
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+
+#include "latency_trace.h"
+#include "log_ring.h"
+#if PSL_PARALLEL_OUTPUT
+#include "bitplane.h"
+#include "ws2812_parallel.pio.h"
+#else
+#include "ws2812.pio.h"
+#endif
+
+#if PSL_PARALLEL_OUTPUT && PSL_RUN_LIST_OUTPUT
+#error "PSL_RUN_LIST_OUTPUT streams GRB words and cannot feed the parallel program"
+#endif
+
+#define WS2812_FREQ_HZ 800000.0f
+#define WS2812_DMA_IRQ_INDEX 0
+#define WS2812_DMA_IRQ DMA_IRQ_0
+
+/* Joined TX FIFO (8 words) plus the word in the OSR: 30 us per pixel word,
+ * 1.25 us per bit-plane word. */
+#if PSL_PARALLEL_OUTPUT
+#define WS2812_FIFO_DRAIN_US 12u
+#else
+#define WS2812_FIFO_DRAIN_US ((8u + 1u) * 30u)
+#endif
+/* WS2812B-V5 / SK6812 want > 280 us of low before latching. */
+#define WS2812_RESET_US 300u
+
+typedef enum {
+    WS2812_OUTPUT_IDLE = 0,
+    WS2812_OUTPUT_DMA,
+    WS2812_OUTPUT_LATCH
+} ws2812_output_state_t;
+
+typedef struct {
+    PIO pio;
+    uint sm;
+    uint dma_chan;
+    /* The chain's slice of the front buffer, in PIO words. */
+    uint16_t first_word;
+    uint16_t word_count;
+#if PSL_RUN_LIST_OUTPUT
+    /* Next word to expand, the end of this frame's prefix, the line buffer
+     * the DMA is reading and how many words wait in the other one. */
+    uint16_t stream_next;
+    uint16_t stream_end;
+    uint8_t stream_line;
+    uint16_t stream_queued;
+#endif
+} ws2812_chain_t;
+
+static ws2812_chain_t chains[WS2812_MAX_STRIPS];
+static uint chain_count = 0;
+/* DMA channels of the chains that have LEDs; triggered together. */
+static uint32_t chain_dma_mask = 0;
+/* Where each block holds our program, -1 until loaded; reset by ws2812_output_init(). */
+static int program_offsets[NUM_PIOS];
+static uint16_t out_led_count = 0;
+static alarm_pool_t *latch_alarm_pool = NULL;
+
+#if PSL_PARALLEL_OUTPUT
+/*
+ * Frames are rendered into staging and transposed into the back buffer on
+ * commit; the front/back pair holds bit planes for the single state machine.
+ */
+static uint32_t staging[WS2812_MAX_LEDS];
+static uint32_t framebuffers[2][WS2812_PARALLEL_MAX_ROWS * BITPLANE_WORDS_PER_ROW];
+static uint16_t lane_start[BITPLANE_LANES];
+static uint16_t lane_len[BITPLANE_LANES];
+static uint lane_count = 0;
+static uint16_t lane_rows = 0;
+#elif PSL_RUN_LIST_OUTPUT
+static run_list_t frames[2];
+static uint32_t line_buffers[WS2812_MAX_STRIPS][2][WS2812_STREAM_CHUNK];
+#else
+static uint32_t framebuffers[2][WS2812_MAX_LEDS];
+#endif
+static volatile uint8_t front_index = 0;
+
+static volatile ws2812_output_state_t out_state = WS2812_OUTPUT_IDLE;
+static volatile uint32_t dma_busy_mask = 0;
+static volatile bool commit_pending = false;
+static volatile uint32_t frames_sent = 0;
+static volatile uint32_t frames_coalesced = 0;
+static volatile uint32_t frames_unchanged = 0;
+
+/*
+ * Words each chain clocks out for the committed frame: WS2812s latch
+ * whatever prefix they were sent, so a chain stops after the last word that
+ * differs from the frame before it. The first frame after init is sent
+ * whole, since nothing is known about the strip.
+ */
+static uint16_t commit_words[WS2812_MAX_STRIPS];
+static uint32_t commit_dma_mask = 0;
+static bool full_refresh = true;
+
+#if PSL_RUN_LIST_OUTPUT
+/* Expand the chain's next words from the front run list into a line buffer. */
+static uint16_t stream_fill(ws2812_chain_t *chain, uint32_t *line) {
+    uint16_t words = (uint16_t)(chain->stream_end - chain->stream_next);
+    if (words > WS2812_STREAM_CHUNK) {
+        words = WS2812_STREAM_CHUNK;
+    }
+    run_list_expand(&frames[front_index], chain->stream_next, line, words);
+    chain->stream_next = (uint16_t)(chain->stream_next + words);
+    return words;
+}
+
+/* Point the chain's DMA at its first line buffer and queue the second. */
+static void arm_chain(uint index, uint16_t words) {
+    ws2812_chain_t *chain = &chains[index];
+    chain->stream_next = chain->first_word;
+    chain->stream_end = (uint16_t)(chain->first_word + words);
+    chain->stream_line = 0;
+    uint16_t first = stream_fill(chain, line_buffers[index][0]);
+    chain->stream_queued = stream_fill(chain, line_buffers[index][1]);
+    dma_channel_set_read_addr(chain->dma_chan, line_buffers[index][0], false);
+    dma_channel_set_trans_count(chain->dma_chan, first, false);
+}
+
+/* From the DMA IRQ: send the queued line buffer and refill the one just
+ * sent. False once the chain's prefix is all out. */
+static bool stream_continue(uint index) {
+    ws2812_chain_t *chain = &chains[index];
+    if (!chain->stream_queued) {
+        return false;
+    }
+    chain->stream_line ^= 1u;
+    dma_channel_transfer_from_buffer_now(chain->dma_chan, line_buffers[index][chain->stream_line],
+                                         chain->stream_queued);
+    chain->stream_queued = stream_fill(chain, line_buffers[index][chain->stream_line ^ 1u]);
+    return true;
+}
+#else
+static void arm_chain(uint index, uint16_t words) {
+    const uint32_t *front = framebuffers[front_index];
+    dma_channel_set_read_addr(chains[index].dma_chan, front + chains[index].first_word, false);
+    dma_channel_set_trans_count(chains[index].dma_chan, words, false);
+}
+#endif
+
+/* Called with interrupts disabled or from the latch alarm. */
+static void swap_and_start_frame(void) {
+    commit_pending = false;
+    front_index ^= 1u;
+    out_state = WS2812_OUTPUT_DMA;
+    latency_trace_frame_started();
+    full_refresh = false;
+    for (uint i = 0; i < chain_count; ++i) {
+        if (commit_words[i]) {
+            arm_chain(i, commit_words[i]);
+        }
+    }
+    dma_busy_mask = commit_dma_mask;
+    dma_start_channel_mask(commit_dma_mask);
+}
+
+/* Fill commit_words from the back buffer against the front one (the frame
+ * on the strip or on its way there); returns the DMA channels to start. */
+static uint32_t measure_dirty_prefixes(void) {
+    uint32_t mask = 0;
+    for (uint i = 0; i < chain_count; ++i) {
+        uint16_t words = chains[i].word_count;
+#if PSL_RUN_LIST_OUTPUT
+        if (!full_refresh) {
+            const uint16_t first = chains[i].first_word;
+            words = (uint16_t)(run_list_last_difference(&frames[front_index ^ 1u], &frames[front_index], first,
+                                                        (uint16_t)(first + words)) - first);
+        }
+#else
+        const uint32_t *b = framebuffers[front_index ^ 1u] + chains[i].first_word;
+        const uint32_t *f = framebuffers[front_index] + chains[i].first_word;
+        if (!full_refresh) {
+            while (words && b[words - 1u] == f[words - 1u]) {
+                words--;
+            }
+        }
+#endif
+#if PSL_PARALLEL_OUTPUT
+        /* Whole rows: a pixel's 24 bit planes go out together. */
+        words = (uint16_t)((words + BITPLANE_WORDS_PER_ROW - 1u) / BITPLANE_WORDS_PER_ROW * BITPLANE_WORDS_PER_ROW);
+#endif
+        commit_words[i] = words;
+        if (words) {
+            mask |= 1u << chains[i].dma_chan;
+        }
+    }
+    return mask;
+}
+
+static int64_t latch_done_alarm(alarm_id_t id, void *user_data) {
+    (void)id;
+    (void)user_data;
+    /* The alarm fires a reset time after the FIFO drained. */
+    latency_trace_frame_on_wire(time_us_32() - WS2812_RESET_US);
+    frames_sent++;
+    if (commit_pending) {
+        swap_and_start_frame();
+    } else {
+        out_state = WS2812_OUTPUT_IDLE;
+    }
+    return 0;
+}
+
+static void ws2812_dma_irq_handler(void) {
+    uint32_t done = 0;
+    for (uint i = 0; i < chain_count; ++i) {
+        uint chan = chains[i].dma_chan;
+        if (dma_irqn_get_channel_status(WS2812_DMA_IRQ_INDEX, chan)) {
+            dma_irqn_acknowledge_channel(WS2812_DMA_IRQ_INDEX, chan);
+#if PSL_RUN_LIST_OUTPUT
+            if (stream_continue(i)) {
+                continue;
+            }
+#endif
+            done |= 1u << chan;
+        }
+    }
+    if (!done) {
+        return;
+    }
+    /* Latch once the longest chain has been fed. */
+    dma_busy_mask &= ~done;
+    if (dma_busy_mask) {
+        return;
+    }
+    out_state = WS2812_OUTPUT_LATCH;
+    if (alarm_pool_add_alarm_in_us(latch_alarm_pool, WS2812_FIFO_DRAIN_US + WS2812_RESET_US,
+                                   latch_done_alarm, NULL, true) < 0) {
+        latch_done_alarm(0, NULL);
+    }
+}
+
+/* A state machine on the first PIO block with one free and room for the program. */
+static bool claim_state_machine(ws2812_chain_t *chain, const pio_program_t *program) {
+    for (uint b = 0; b < NUM_PIOS; ++b) {
+        PIO pio = pio_get_instance(b);
+        if (program_offsets[b] < 0 && !pio_can_add_program(pio, program)) {
+            continue;
+        }
+        int sm = pio_claim_unused_sm(pio, false);
+        if (sm < 0) {
+            continue;
+        }
+        if (program_offsets[b] < 0) {
+            program_offsets[b] = (int)pio_add_program(pio, program);
+        }
+        chain->pio = pio;
+        chain->sm = (uint)sm;
+        return true;
+    }
+    return false;
+}
+
+static void configure_chain_dma(ws2812_chain_t *chain) {
+    dma_channel_config cfg = dma_channel_get_default_config(chain->dma_chan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, pio_get_dreq(chain->pio, chain->sm, true));
+    dma_channel_configure(chain->dma_chan, &cfg, &chain->pio->txf[chain->sm], NULL, 0, false);
+}
+
+#if PSL_PARALLEL_OUTPUT
+/* One state machine and DMA channel drive every lane from pin_base up. */
+static bool claim_chain(ws2812_chain_t *chain, uint pin_base, uint pin_count) {
+    if (!claim_state_machine(chain, &ws2812_parallel_program)) {
+        PSL_LOG_ERROR("ws2812: no free PIO state machine for pins %u..%u\n", pin_base, pin_base + pin_count - 1u);
+        return false;
+    }
+    int chan = dma_claim_unused_channel(false);
+    if (chan < 0) {
+        PSL_LOG_ERROR("ws2812: no free DMA channel for pins %u..%u\n", pin_base, pin_base + pin_count - 1u);
+        pio_sm_unclaim(chain->pio, chain->sm);
+        return false;
+    }
+    chain->dma_chan = (uint)chan;
+    uint offset = (uint)program_offsets[pio_get_index(chain->pio)];
+    ws2812_parallel_program_init(chain->pio, chain->sm, offset, pin_base, pin_count, WS2812_FREQ_HZ);
+    configure_chain_dma(chain);
+    return true;
+}
+#else
+static bool claim_chain(ws2812_chain_t *chain, uint pin) {
+    if (!claim_state_machine(chain, &ws2812_program)) {
+        PSL_LOG_ERROR("ws2812: no free PIO state machine for pin %u\n", pin);
+        return false;
+    }
+    int chan = dma_claim_unused_channel(false);
+    if (chan < 0) {
+        PSL_LOG_ERROR("ws2812: no free DMA channel for pin %u\n", pin);
+        pio_sm_unclaim(chain->pio, chain->sm);
+        return false;
+    }
+    chain->dma_chan = (uint)chan;
+    uint offset = (uint)program_offsets[pio_get_index(chain->pio)];
+    ws2812_program_init(chain->pio, chain->sm, offset, pin, WS2812_FREQ_HZ, false);
+    configure_chain_dma(chain);
+    return true;
+}
+
+static void release_chains(uint count) {
+    for (uint i = 0; i < count; ++i) {
+        pio_sm_set_enabled(chains[i].pio, chains[i].sm, false);
+        pio_sm_unclaim(chains[i].pio, chains[i].sm);
+        dma_channel_unclaim(chains[i].dma_chan);
+    }
+}
+#endif
+
+uint ws2812_output_max_strips(void) {
+#if PSL_PARALLEL_OUTPUT
+    return WS2812_MAX_STRIPS;
+#else
+    /* Ours count as free: a new config replaces them after the reboot. */
+    uint free_sms = 0;
+    for (uint b = 0; b < NUM_PIOS; ++b) {
+        PIO pio = pio_get_instance(b);
+        for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; ++sm) {
+            bool ours = false;
+            for (uint i = 0; i < chain_count; ++i) {
+                ours |= chains[i].pio == pio && chains[i].sm == sm;
+            }
+            if (ours || !pio_sm_is_claimed(pio, sm)) {
+                free_sms++;
+            }
+        }
+    }
+    return free_sms < WS2812_MAX_STRIPS ? free_sms : WS2812_MAX_STRIPS;
+#endif
+}
+
+bool ws2812_output_init(const ws2812_strip_t *strips, uint strip_count) {
+    if (strip_count == 0 || strip_count > WS2812_MAX_STRIPS) {
+        PSL_LOG_ERROR("ws2812: %u strips requested, 1..%u supported\n", strip_count, WS2812_MAX_STRIPS);
+        return false;
+    }
+    for (uint b = 0; b < NUM_PIOS; ++b) {
+        program_offsets[b] = -1;
+    }
+    uint16_t first_led = 0;
+    uint16_t longest = 0;
+    uint32_t dma_mask = 0;
+#if PSL_PARALLEL_OUTPUT
+    for (uint i = 1; i < strip_count; ++i) {
+        if (strips[i].pin != strips[0].pin + i) {
+            PSL_LOG_ERROR("ws2812: parallel output needs consecutive pins, strip %u is on %u\n", i,
+                          strips[i].pin);
+            return false;
+        }
+    }
+    for (uint i = 0; i < strip_count; ++i) {
+        uint16_t room = (uint16_t)(WS2812_MAX_LEDS - first_led);
+        lane_start[i] = first_led;
+        lane_len[i] = strips[i].led_count < room ? strips[i].led_count : room;
+        first_led = (uint16_t)(first_led + lane_len[i]);
+        if (lane_len[i] > longest) {
+            longest = lane_len[i];
+        }
+    }
+    if (longest > WS2812_PARALLEL_MAX_ROWS) {
+        PSL_LOG_ERROR("ws2812: chain of %u LEDs, parallel output supports %u\n", longest,
+                      WS2812_PARALLEL_MAX_ROWS);
+        return false;
+    }
+    if (!claim_chain(&chains[0], strips[0].pin, strip_count)) {
+        return false;
+    }
+    chains[0].first_word = 0;
+    chains[0].word_count = (uint16_t)(longest * BITPLANE_WORDS_PER_ROW);
+    if (longest) {
+        dma_mask = 1u << chains[0].dma_chan;
+    }
+    lane_count = strip_count;
+    lane_rows = longest;
+    chain_count = 1;
+#else
+    for (uint i = 0; i < strip_count; ++i) {
+        ws2812_chain_t *chain = &chains[i];
+        if (!claim_chain(chain, strips[i].pin)) {
+            release_chains(i);
+            return false;
+        }
+        uint16_t room = (uint16_t)(WS2812_MAX_LEDS - first_led);
+        chain->first_word = first_led;
+        chain->word_count = strips[i].led_count < room ? strips[i].led_count : room;
+        first_led = (uint16_t)(first_led + chain->word_count);
+        if (chain->word_count) {
+            dma_mask |= 1u << chain->dma_chan;
+        }
+        if (chain->word_count > longest) {
+            longest = chain->word_count;
+        }
+    }
+    chain_count = strip_count;
+#endif
+    /* A private pool keeps the latch alarm on this core, next to the DMA IRQ. */
+    latch_alarm_pool = alarm_pool_create_with_unused_hardware_alarm(2);
+
+    chain_dma_mask = dma_mask;
+    out_led_count = first_led;
+#if PSL_RUN_LIST_OUTPUT
+    run_list_reset(&frames[0], out_led_count, 0);
+    run_list_reset(&frames[1], out_led_count, 0);
+#endif
+
+    irq_add_shared_handler(WS2812_DMA_IRQ, ws2812_dma_irq_handler,
+                           PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    for (uint i = 0; i < chain_count; ++i) {
+        dma_irqn_set_channel_enabled(WS2812_DMA_IRQ_INDEX, chains[i].dma_chan, true);
+    }
+    irq_set_enabled(WS2812_DMA_IRQ, true);
+    PSL_LOG_INFO("ws2812: %u LEDs on %u strips, longest chain %u\n", out_led_count, strip_count, longest);
+    return true;
+}
+
+uint16_t ws2812_output_led_count(void) {
+    return out_led_count;
+}
+
+uint ws2812_output_strip_count(void) {
+#if PSL_PARALLEL_OUTPUT
+    return lane_count;
+#else
+    return chain_count;
+#endif
+}
+
+#if PSL_RUN_LIST_OUTPUT
+run_list_t *ws2812_output_begin_runs(void) {
+    uint32_t irq_state = save_and_disable_interrupts();
+    if (commit_pending) {
+        commit_pending = false;
+        frames_coalesced++;
+    }
+    run_list_t *back = &frames[front_index ^ 1u];
+    restore_interrupts(irq_state);
+    return back;
+}
+#else
+uint32_t *ws2812_output_begin_frame(void) {
+    uint32_t irq_state = save_and_disable_interrupts();
+    if (commit_pending) {
+        commit_pending = false;
+        frames_coalesced++;
+    }
+#if PSL_PARALLEL_OUTPUT
+    uint32_t *back = staging;
+#else
+    uint32_t *back = framebuffers[front_index ^ 1u];
+#endif
+    restore_interrupts(irq_state);
+    return back;
+}
+#endif
+
+void ws2812_output_commit_frame(void) {
+    if (!chain_dma_mask) {
+        return;
+    }
+#if PSL_PARALLEL_OUTPUT
+    /* begin_frame() withdrew any pending commit, so nothing swaps the back
+     * buffer while it is rewritten here. */
+    bitplane_transpose(framebuffers[front_index ^ 1u], staging, lane_start, lane_len, lane_count, lane_rows);
+#endif
+    uint32_t dirty_mask = measure_dirty_prefixes();
+    uint32_t irq_state = save_and_disable_interrupts();
+    if (!dirty_mask) {
+        latency_trace_frame_unchanged();
+        frames_unchanged++;
+    } else {
+        commit_dma_mask = dirty_mask;
+        latency_trace_frame_committed();
+        if (out_state == WS2812_OUTPUT_IDLE) {
+            swap_and_start_frame();
+        } else {
+            commit_pending = true;
+        }
+    }
+    restore_interrupts(irq_state);
+}
+
+bool ws2812_output_commit_pending(void) {
+    return commit_pending;
+}
+
+bool ws2812_output_busy(void) {
+    return out_state != WS2812_OUTPUT_IDLE;
+}
+
+void ws2812_output_wait_idle(void) {
+    while (ws2812_output_busy()) {
+        tight_loop_contents();
+    }
+}
+
+uint32_t ws2812_output_frames_sent(void) {
+    return frames_sent;
+}
+
+uint32_t ws2812_output_frames_coalesced(void) {
+    return frames_coalesced;
+}
+
+uint32_t ws2812_output_frames_unchanged(void) {
+    return frames_unchanged;
+}
@@ -0,0 +1,117 @@
+#ifndef WS2812_OUTPUT_H
+#define WS2812_OUTPUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hardware/pio.h"
+#include "run_list.h"
+
+/* Frames as run lists expanded while they are sent, instead of framebuffers. */
+#ifndef PSL_RUN_LIST_OUTPUT
+#define PSL_RUN_LIST_OUTPUT 0
+#endif
+
+#ifndef WS2812_MAX_LEDS
+#if PSL_RUN_LIST_OUTPUT
+#define WS2812_MAX_LEDS 8192
+#else
+#define WS2812_MAX_LEDS 1024
+#endif
+#endif
+
+/* Words per line buffer when streaming run lists; two per chain. */
+#ifndef WS2812_STREAM_CHUNK
+#define WS2812_STREAM_CHUNK 32u
+#endif
+
+/* Four state machines per PIO block, both blocks; fewer may be free (see
+ * ws2812_output_max_strips()). */
+#define WS2812_MAX_STRIPS 8u
+
+/* Drive all strips from one state machine as bit planes (see bitplane.h). */
+#ifndef PSL_PARALLEL_OUTPUT
+#define PSL_PARALLEL_OUTPUT 0
+#endif
+
+/* Longest chain the parallel engine buffers; each row is 24 words. */
+#ifndef WS2812_PARALLEL_MAX_ROWS
+#define WS2812_PARALLEL_MAX_ROWS 128u
+#endif
+
+/*
+ * DMA-fed WS2812 output. Frames are arrays of PIO words (GRB in the top 24
+ * bits) which a DMA channel paced by the state machine's TX DREQ clocks out
+ * while the CPU keeps running. A frame stays "in flight" until the PIO FIFO
+ * has drained and the strip reset/latch time has elapsed.
+ *
+ * The engine owns a front/back framebuffer pair. The DMA only ever reads the
+ * front buffer; callers render into the back buffer and commit it, and the
+ * buffers are swapped at the next frame boundary. Each chain is only sent
+ * up to its last pixel that differs from the previous frame, which the
+ * LEDs past it keep showing; a frame with no changes is not sent at all.
+ *
+ * A long run can be split into up to WS2812_MAX_STRIPS chains on separate
+ * pins, each with its own state machine and DMA channel. The chains take
+ * consecutive slices of the framebuffer in order and all their DMA channels
+ * are triggered in the same cycle, so a frame occupies the wire only as
+ * long as the longest chain needs.
+ *
+ * With PSL_PARALLEL_OUTPUT the strips must sit on consecutive pins and one
+ * state machine drives them all, one bit of every lane per word. Callers
+ * still render GRB words into the buffer from begin_frame(); commit
+ * transposes them into bit planes, which costs CPU time but only one state
+ * machine and one DMA channel.
+ *
+ * With PSL_RUN_LIST_OUTPUT the front/back pair are run lists of PIO words
+ * instead (ws2812_output_begin_runs()). Each chain streams its slice from
+ * two WS2812_STREAM_CHUNK-word line buffers: the DMA completion interrupt
+ * starts the filled one and refills the other, so RAM no longer grows with
+ * the LED count. The FIFO drain time covers the interrupt latency.
+ */
+
+typedef struct {
+    uint pin;
+    uint16_t led_count;
+} ws2812_strip_t;
+
+/*
+ * Call on the core that renders: the DMA and latch interrupts run there.
+ * State machines come from pio0, then pio1. On failure everything claimed
+ * so far is released. The total LED count is clipped to WS2812_MAX_LEDS.
+ * In parallel mode the longest strip must fit WS2812_PARALLEL_MAX_ROWS.
+ */
+bool ws2812_output_init(const ws2812_strip_t *strips, uint strip_count);
+/* Chains ws2812_output_init() could claim a state machine for now, counting
+ * the ones it already holds; the radio on a Pico W keeps one for itself. */
+uint ws2812_output_max_strips(void);
+uint16_t ws2812_output_led_count(void);
+uint ws2812_output_strip_count(void);
+
+/*
+ * Return the back buffer for rendering. A committed frame that has not been
+ * swapped in yet is withdrawn, so the caller can overwrite it with a newer
+ * frame; that is how bursts of commands collapse into one strip refresh.
+ * It is never the buffer DMA reads from, so rendering need not wait for the
+ * frame in flight; the pointer is good until ws2812_output_commit_frame().
+ */
+#if PSL_RUN_LIST_OUTPUT
+run_list_t *ws2812_output_begin_runs(void);
+#else
+uint32_t *ws2812_output_begin_frame(void);
+#endif
+
+/* Mark the back buffer complete; it is swapped to the front and sent as soon
+ * as the frame in flight (if any) has latched. Call after begin_frame(). */
+void ws2812_output_commit_frame(void);
+
+/* True if a committed frame is still waiting for the one in flight. */
+bool ws2812_output_commit_pending(void);
+
+bool ws2812_output_busy(void);
+void ws2812_output_wait_idle(void);
+uint32_t ws2812_output_frames_sent(void);
+uint32_t ws2812_output_frames_coalesced(void);
+/* Committed frames identical to the one before, which were not sent. */
+uint32_t ws2812_output_frames_unchanged(void);
+
+#endif
